@@ -9,6 +9,7 @@
 #include <iostream>
 #include <algorithm> 
 #include <vector>
+#include <memory> //for std::unique_ptr
 #include <fstream>
 #include <cstring> //for cstring operations
 #include <random>
@@ -16,31 +17,412 @@
 #include <string>
 #include <stdexcept>
 #include <limits>
+#include <string_view>
+#include <unordered_map> //for CompiledModel state lookup
+#include <cstdint>
+#include <array> //for the successor bitmap
+#include <span> //for sorting the corpus bytes in place
+#include <bit> //for std::popcount
+#include <compare> //for operator<=> and std::compare_weak_order_fallback
+#include <memory_resource> //for the AVLTree node arenas
+#include <new> //for std::align_val_t
+#include <optional> //for a compiled or frozen model that may be refused
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> //SSE2 prefix-sum compare in SuccessorList
+#endif
 #include <stdexcept>  // For std::stoll
 
+#if defined(_WIN32)
+#define CORPUS_HAS_MMAP 0 //No mmap on Windows: the corpus is read into a buffer instead
+#else
+#include <sys/mman.h> //for mmap, madvise
+#include <fcntl.h> //for open
+#include <unistd.h> //for close
+#define CORPUS_HAS_MMAP 1
+#endif
+
 /**
- * @class AVLTree
- * @brief Implements a self-balancing Binary Search Tree using the AVL Tree algorithm.
+ * @class MappedCorpus
+ * @brief Read-only view of the whole input file as one contiguous range of bytes.
  *
- * The AVLTree class provides an efficient binary search tree where the tree automatically balances itself
- * after each insertion to ensure that it remains balanced. This balance ensures that the operations
- * like insertion, deletion, and lookup are performed in O(log n) time. The AVLTree maintains the height-balanced
- * property, which states that the height difference between the left and right subtree of any node is no more than 1.
+ * The file is memory-mapped, so ingestion walks a plain `const char*` range instead of doing a `file.get()` and a
+ * `file.peek()` per byte. Where mmap is not available (or mapping fails) the file is read into a buffer once, which
+ * gives the same contiguous view. The mapping is not advised for sequential access: keys, frozen and compiled
+ * models and index probes keep reading it at random after ingestion, so its pages must not be dropped behind the
+ * first pass.
+ * The corpus must outlive every structure that refers to its bytes.
+ */
+class MappedCorpus {
+    private:
+        const char* bytes; // First byte of the corpus
+        std::size_t length; // Number of bytes in the corpus
+        bool mapped; // True if bytes points into an mmap region that has to be unmapped
+        std::vector<char> fallback; // Owns the bytes when the file could not be mapped
+
+        /**
+         * @brief Read the whole file into the fallback buffer
+         * @param path Path of the input file
+         * @throw std::runtime_error if the file can not be read
+         */
+        void readIntoBuffer(const std::string & path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Error opening input file!");
+            }
+            fallback.resize(length);
+            if (length > 0 && !file.read(fallback.data(), static_cast<std::streamsize>(length))) {
+                throw std::runtime_error("Error reading input file!");
+            }
+            bytes = fallback.data();
+        }
+
+    public:
+        /**
+         * @brief Map the file at path
+         * @param path Path of the input file
+         * @param file_length Size of the file in bytes (from the seekg/tellg probe in main)
+         * @throw std::runtime_error if the file can not be opened or read
+         */
+        MappedCorpus(const std::string & path, std::size_t file_length) : bytes(nullptr), length(file_length), mapped(false) {
+#if CORPUS_HAS_MMAP
+            if (length > 0) {
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::runtime_error("Error opening input file!");
+                }
+                void* region = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd); //The mapping stays valid after the descriptor is closed
+                if (region != MAP_FAILED) {
+                    ::madvise(region, length, MADV_WILLNEED); //Start reading the file in ahead of ingestion
+                    bytes = static_cast<const char*>(region);
+                    mapped = true;
+                    return;
+                }
+            }
+#endif
+            readIntoBuffer(path); //No mmap (or it failed): fall back to one buffered read
+        }
+
+        ~MappedCorpus() {
+#if CORPUS_HAS_MMAP
+            if (mapped) {
+                ::munmap(const_cast<char*>(bytes), length);
+            }
+#endif
+        }
+
+        MappedCorpus(const MappedCorpus &) = delete;
+        MappedCorpus & operator=(const MappedCorpus &) = delete;
+
+        const char* data() const { return bytes; }
+        std::size_t size() const { return length; }
+        const char* begin() const { return bytes; }
+        const char* end() const { return bytes + length; }
+};
+
+/**
+ * @struct CorpusKey
+ * @brief A context key that refers to its bytes instead of owning a copy of them.
  *
- * The class supports operations such as insertion and in-order traversal. Balancing is performed using 
- * rotations (single and double), and the height of each node is updated during insertion to maintain balance.
+ * A CorpusKey is a (position, length) pair: `bytes` points at an offset inside the mapped corpus and `length` is the
+ * window size. Keys stored in a model always point into the corpus, so a model costs the same per context whatever
+ * the window size. Probe keys used for lookups may point anywhere (e.g. into the generated output).
+ * Comparisons and hashes read the referenced bytes directly.
+ */
+struct CorpusKey {
+    const char* bytes; // First byte of the context (an offset into the corpus for stored keys)
+    std::size_t length; // Number of bytes in the context
+
+    CorpusKey() : bytes(nullptr), length(0) {}
+    CorpusKey(const char* b, std::size_t len) : bytes(b), length(len) {}
+
+    /**
+     * @brief Lexicographic byte comparison
+     * @return negative, zero or positive like std::memcmp
+     */
+    int compare(const CorpusKey & other) const {
+        int result = std::memcmp(bytes, other.bytes, std::min(length, other.length));
+        if (result != 0) {
+            return result;
+        }
+        return (length < other.length) ? -1 : (length > other.length ? 1 : 0);
+    }
+
+    std::strong_ordering operator<=>(const CorpusKey & other) const { return compare(other) <=> 0; }
+    bool operator<(const CorpusKey & other) const { return compare(other) < 0; }
+    bool operator>(const CorpusKey & other) const { return compare(other) > 0; }
+    bool operator==(const CorpusKey & other) const {
+        return length == other.length && std::memcmp(bytes, other.bytes, length) == 0;
+    }
+};
+
+// Print the referenced bytes of a CorpusKey
+std::ostream & operator<<(std::ostream & out, const CorpusKey & key) {
+    return out.write(key.bytes, static_cast<std::streamsize>(key.length));
+}
+
+/**
+ * @brief Pack the first 8 bytes of a key into a big-endian integer, zero-padded past the end of the key
  *
- * @tparam Comparable The data type to store in the tree, which must support comparison operators.
+ * Unsigned integer order on two prefixes agrees with memcmp order on the keys: a smaller prefix means a smaller key,
+ * and only equal prefixes need the full comparison.
  */
-template <typename KeyType, typename ValueType>
-class AVLTree {
+std::uint64_t loadKeyPrefix(const char* bytes, std::size_t length) {
+    std::size_t n = std::min<std::size_t>(length, 8);
+    std::uint64_t prefix = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        prefix = (prefix << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return n == 0 ? 0 : prefix << (8 * (8 - n));
+}
+
+/**
+ * @struct KeyPrefix
+ * @brief Which key types AVLTree caches an integer prefix for, and how to compute it
+ *
+ * Other key types (int, double, ...) already compare in one instruction, so they have no prefix.
+ */
+template <typename KeyType>
+struct KeyPrefix {
+    static constexpr bool CACHED = false;
+    static std::uint64_t of(const KeyType &) { return 0; }
+};
+
+template <>
+struct KeyPrefix<CorpusKey> {
+    static constexpr bool CACHED = true;
+    static std::uint64_t of(const CorpusKey & key) { return loadKeyPrefix(key.bytes, key.length); }
+};
+
+template <>
+struct KeyPrefix<std::string> {
+    static constexpr bool CACHED = true;
+    static std::uint64_t of(const std::string & key) { return loadKeyPrefix(key.data(), key.size()); }
+};
+
+// How SuccessorList picks a weighted random value
+enum SamplerKind {
+    SCAN_SAMPLER, // Sum the counts, then scan for the cumulative bucket (two linear passes, nothing to build)
+    ALIAS_SAMPLER, // Walker/Vose alias table: O(1) per sample, O(n) to build after the counts change
+    PREFIX_SAMPLER // Cached prefix sums + branchless binary search (SSE2 compare for 16 values or fewer): cheap to rebuild
+};
+
+/**
+ * @class SuccessorSampler
+ * @brief The sampling structures of one successor list, built over its counts.
+ *
+ * The default sampler uses an alias table (Walker/Vose): after it is built, a sample costs one random number and
+ * one or two array reads instead of two passes over the values. The prefix sampler keeps the cumulative counts
+ * instead, which is cheaper to rebuild while the model is still being updated, and finds the bucket with a
+ * branchless binary search. Either structure is built by finalize(), or lazily by the first sample after
+ * invalidate() (the counts changed), so only contexts that changed are rebuilt.
+ *
+ * The counts are not stored here: each call gets the list's entries (anything with a count member) and their total,
+ * so SuccessorList and its compact char form share this code.
+ */
+class SuccessorSampler {
     private:
+        static constexpr size_t SIMD_PREFIX_LIMIT = 16; // Up to this many values, the prefix sampler compares all sums at once
+
         /**
-         * @struct ValueCount
-         * @brief Store all values associated with the key and the count of each value association
+         * @struct AliasSlot
+         * @brief One column of the alias table: keep value i if the draw is below cut, else take value alias
+         */
+        struct AliasSlot {
+            std::uint32_t cut; // Threshold in [0, totalWeight]
+            std::uint32_t alias; // Index of the value that fills the rest of the column
+        };
+
+        std::pmr::vector<AliasSlot> aliasTable; // One column per value, valid only if aliasValid
+        std::pmr::vector<std::uint32_t> prefixSums; // prefixSums[i] = count of values 0..i, padded to a multiple of 4; valid only if prefixValid
+        bool aliasValid; // False after invalidate() until the alias table is rebuilt
+        bool prefixValid; // False after invalidate() until the prefix sums are rebuilt
+
+        /**
+         * @brief Build the alias table with Vose's method, in integer arithmetic so it is exact.
          *
-         * The ValueCount is used to stored associated values of each AvlNode
-         * Count how many time each value accociate with the AvlNode
+         * Each count is scaled by the number of values n, so an average column holds exactly totalWeight.
+         * Columns below average are topped up from a column above average, which becomes their alias.
+         */
+        template <typename Entry>
+        void buildAlias(const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            aliasTable.assign(n, AliasSlot{totalWeight, 0});
+            std::vector<std::uint64_t> scaled(n);
+            std::vector<std::uint32_t> small, large;
+            for (size_t i = 0; i < n; i++) {
+                scaled[i] = static_cast<std::uint64_t>(entries[i].count) * n;
+                aliasTable[i].alias = static_cast<std::uint32_t>(i);
+                (scaled[i] < totalWeight ? small : large).push_back(static_cast<std::uint32_t>(i));
+            }
+            while (!small.empty() && !large.empty()) {
+                std::uint32_t s = small.back(); small.pop_back();
+                std::uint32_t l = large.back(); large.pop_back();
+                aliasTable[s].cut = static_cast<std::uint32_t>(scaled[s]);
+                aliasTable[s].alias = l;
+                scaled[l] -= totalWeight - scaled[s]; // l gives away what fills up column s
+                (scaled[l] < totalWeight ? small : large).push_back(l);
+            }
+            // Whatever is left is exactly average: those columns keep their own value
+            aliasValid = true;
+        }
+
+        /**
+         * @brief Build the cumulative counts; the padding never compares <= a draw
+         */
+        template <typename Entry>
+        void buildPrefix(const Entry* entries, size_t n) {
+            prefixSums.assign((n + 3) & ~size_t(3), static_cast<std::uint32_t>(std::numeric_limits<std::int32_t>::max()));
+            std::uint32_t running = 0;
+            for (size_t i = 0; i < n; i++) {
+                running += entries[i].count;
+                prefixSums[i] = running;
+            }
+            prefixValid = true;
+        }
+
+        /**
+         * @brief The original sampler: sum the counts, then scan for the cumulative bucket
+         * @return The index of the chosen value
+         */
+        template <typename Generator, typename Entry>
+        size_t sampleScan(Generator & rand_num_gen, const Entry* entries, size_t n) const {
+            int totalWeight = 0;
+            //Calculate total weight
+            for (size_t i = 0; i < n; i++) {
+                    totalWeight += entries[i].count;
+            }
+            // Generate a random number between 0 and totalWeight - 1
+            std::uniform_int_distribution<int> dist(0, totalWeight - 1);
+            int randNum = dist(rand_num_gen);
+            // Traverse the array and select the value based on the random number
+            int cumulativeWeight = 0;
+            for (size_t i = 0; i < n; i++) {
+                cumulativeWeight += entries[i].count;
+                if (randNum < cumulativeWeight) {
+                    return i; // Pick this value
+                }
+            }
+            return 0; //Fallback, though we should never reach here
+        }
+
+        /**
+         * @brief One random number in [0, n * totalWeight) picks both the alias column and the position inside it
+         * @return The index of the chosen value
+         */
+        template <typename Generator, typename Entry>
+        size_t sampleAlias(Generator & rand_num_gen, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            if (!aliasValid) {
+                buildAlias(entries, n, totalWeight); // Rebuilds only if the counts changed since the last build
+            }
+            std::uint64_t range = static_cast<std::uint64_t>(n) * totalWeight;
+            std::uint64_t randNum;
+            if (range <= std::numeric_limits<std::uint32_t>::max()) {
+                // One 32-bit draw is enough (the common case); a 64-bit distribution would draw twice from mt19937
+                std::uniform_int_distribution<std::uint32_t> dist(0, static_cast<std::uint32_t>(range - 1));
+                randNum = dist(rand_num_gen);
+            } else {
+                std::uniform_int_distribution<std::uint64_t> dist(0, range - 1);
+                randNum = dist(rand_num_gen);
+            }
+            size_t column = static_cast<size_t>(randNum / totalWeight);
+            return (randNum % totalWeight < aliasTable[column].cut) ? column : aliasTable[column].alias;
+        }
+
+        /**
+         * @brief Find the first prefix sum greater than the draw: the number of sums <= the draw is its index
+         * @return The index of the chosen value
+         */
+        template <typename Generator, typename Entry>
+        size_t samplePrefix(Generator & rand_num_gen, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            if (!prefixValid) {
+                buildPrefix(entries, n);
+            }
+            std::uniform_int_distribution<std::uint32_t> dist(0, totalWeight - 1);
+            std::uint32_t randNum = dist(rand_num_gen);
+            size_t index = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            if (n <= SIMD_PREFIX_LIMIT) {
+                // Compare the draw against 4 sums at a time (counts stay below 2^31, so signed compares are safe)
+                __m128i draw = _mm_set1_epi32(static_cast<int>(randNum));
+                for (size_t i = 0; i < prefixSums.size(); i += 4) {
+                    __m128i sums = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&prefixSums[i]));
+                    int notAbove = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(sums, draw))) ^ 0xF;
+                    index += std::popcount(static_cast<unsigned>(notAbove));
+                }
+                return index;
+            }
+#endif
+            // Branchless binary search: the answer stays in [index, index + length)
+            const std::uint32_t* sums = prefixSums.data();
+            for (size_t length = n; length > 1; ) {
+                size_t half = length / 2;
+                index = (sums[index + half - 1] <= randNum) ? index + half : index;
+                length -= half;
+            }
+            return index;
+        }
+
+    public:
+        /**
+         * @param resource Where the tables are allocated (the tree's node arena)
+         */
+        explicit SuccessorSampler(std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+            : aliasTable(resource), prefixSums(resource), aliasValid(false), prefixValid(false) {}
+
+        /**
+         * @brief The counts changed: rebuild whichever structure is used next
+         */
+        void invalidate() {
+            aliasValid = false;
+            prefixValid = false;
+        }
+
+        /**
+         * @brief Build the structure the given sampler needs, if the counts changed since it was last built
+         * @param sampler The sampler that will be used
+         * @param entries The list's values with their counts, n of them, adding up to totalWeight
+         */
+        template <typename Entry>
+        void finalize(SamplerKind sampler, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            if (sampler == ALIAS_SAMPLER && !aliasValid) {
+                buildAlias(entries, n, totalWeight);
+            } else if (sampler == PREFIX_SAMPLER && !prefixValid) {
+                buildPrefix(entries, n);
+            }
+        }
+
+        /**
+         * @brief Draw the index of an entry, weighted by its count (there are at least two entries)
+         * @param rand_num_gen The random number generator of the calling tree
+         * @param sampler Which sampler to use (see SamplerKind)
+         * @param entries The list's values with their counts, n of them, adding up to totalWeight
+         */
+        template <typename Generator, typename Entry>
+        size_t sampleIndex(Generator & rand_num_gen, SamplerKind sampler, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            switch (sampler) {
+                case SCAN_SAMPLER: return sampleScan(rand_num_gen, entries, n);
+                case PREFIX_SAMPLER: return samplePrefix(rand_num_gen, entries, n, totalWeight);
+                default: return sampleAlias(rand_num_gen, entries, n, totalWeight);
+            }
+        }
+};
+
+/**
+ * @class SuccessorList
+ * @brief Store all values associated with a key and the count of each value association
+ *
+ * Each AvlNode keeps one SuccessorList for the values that followed its key. Weighted draws go through a
+ * SuccessorSampler.
+ * Lists of char values (what main() stores) use the compact form below.
+ *
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename ValueType>
+class SuccessorList {
+    public:
+        /**
+         * @struct ValueCount
+         * @brief One value associated with the key and how many times it was associated
          */
         struct ValueCount {
             ValueType value;  // The value associated with the key
@@ -53,496 +435,2363 @@ class AVLTree {
              */
             ValueCount(const ValueType & v, int c) : value(v), count(c) {}
         };
+
+    private:
+        std::pmr::vector<ValueCount> value_count; // Vector of values and their counts
+        std::uint32_t totalWeight; // Sum of all counts
+        SuccessorSampler sampling; // Alias table or prefix sums over value_count
+
+    public:
+        SuccessorList() : totalWeight(0) {}
+
         /**
-         * @struct AvlNode
-         * @brief Represents a node in the AVL Tree.
-         *
-         * The AvlNode struct is used to store individual elements of the AVL Tree. Each node contains an element (the key),
-         * pointers to its left and right children, and its height within the tree.
+         * @brief Start the list with one value (count 1)
+         * @param resource Where the list allocates (the tree's node arena); copies use the default heap
          */
-        struct AvlNode {
-            KeyType key; //Any comparable types: int, float, double, char, std::string, or any custom comparable class or struct
-            std::vector<ValueCount> value_count; // Vector of values and their counts
-            AvlNode *left;
-            AvlNode *right;
-            int height;
+        explicit SuccessorList(const ValueType & v, std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+            : value_count(resource), totalWeight(1), sampling(resource) {
+            value_count.push_back(ValueCount(v, 1));
+        }
+
+        /**
+         * @brief Record one more association with v: increment its count, or add it with count 1
+         * @param v The value that followed the key
+         */
+        void add(const ValueType & v) {
+            totalWeight++;
+            sampling.invalidate(); // The distribution changed
+            for (auto & vc : value_count) {
+                if (vc.value == v) {
+                    vc.count++;  // Increment the count if the value exists
+                    return;
+                }
+            }
+            value_count.push_back(ValueCount(v, 1)); // If not just add a new value
+        }
+
+        /**
+         * @brief Build the structure the given sampler needs, if the counts changed since it was last built
+         * @param sampler The sampler that will be used
+         */
+        void finalize(SamplerKind sampler = ALIAS_SAMPLER) {
+            sampling.finalize(sampler, value_count.data(), value_count.size(), totalWeight);
+        }
+
+        /**
+         * @brief Get a value randomly, weighted by its count.
+         * Value that has a higher count will has a higher chance of being returned.
+         * @param rand_num_gen The random number generator of the calling tree
+         * @param sampler Which sampler to use (see SamplerKind)
+         * @return ValueType value
+         */
+        template <typename Generator>
+        ValueType sample(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            return value_count[sampleIndex(rand_num_gen, sampler)].value;
+        }
+
+        /**
+         * @brief Like sample(), but return the position of the chosen value (see valueAt())
+         */
+        template <typename Generator>
+        size_t sampleIndex(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            if (value_count.size() == 1) {
+                return 0; // Nothing to choose from
+            }
+            return sampling.sampleIndex(rand_num_gen, sampler, value_count.data(), value_count.size(), totalWeight);
+        }
+
+        const ValueType & valueAt(size_t i) const { return value_count[i].value; }
+        std::size_t size() const { return value_count.size(); }
+        typename std::pmr::vector<ValueCount>::const_iterator begin() const { return value_count.begin(); }
+        typename std::pmr::vector<ValueCount>::const_iterator end() const { return value_count.end(); }
+};
+
+/**
+ * @class SuccessorList<char>
+ * @brief Compact successor list for byte values: one successor inline, more in a bitmap-indexed block.
+ *
+ * A context with a single successor (the common case at large window sizes) stores it inline and allocates
+ * nothing. From the second distinct successor on, a Spread block holds a 256-bit presence bitmap and the
+ * ValueCounts of the present bytes in byte order, so the index of byte b is the number of present bytes below b
+ * (a popcount of the bitmap): testing membership and finding the insert position are O(1), with no search.
+ * The interface is the same as the general SuccessorList; values are listed in byte order. The Spread is allocated
+ * from the list's memory resource, like the general list's vectors, so an arena that drops its nodes wholesale
+ * also drops it.
+ */
+template <>
+class SuccessorList<char> {
+    public:
+        /**
+         * @struct ValueCount
+         * @brief One value associated with the key and how many times it was associated
+         */
+        struct ValueCount {
+            char value;  // The value associated with the key
+            int count;  // The count of how many times the value is associated with the key
+
+            ValueCount(char v, int c) : value(v), count(c) {}
+        };
+
+    private:
+        /**
+         * @struct Spread
+         * @brief The successors of a context with two or more of them
+         */
+        struct Spread {
+            std::array<std::uint64_t, 4> present{}; // Bit b is set if byte b is a successor
+            std::pmr::vector<ValueCount> value_count; // The present bytes in byte order, with their counts
+            SuccessorSampler sampling; // Alias table or prefix sums over value_count
+
+            explicit Spread(std::pmr::memory_resource * resource) : value_count(resource), sampling(resource) {}
+            Spread(const Spread & other, std::pmr::memory_resource * resource)
+                : present(other.present), value_count(other.value_count, resource), sampling(resource) {}
+
+            // Index of byte b in value_count: the number of present bytes below b
+            size_t rank(unsigned char b) const {
+                size_t word = b >> 6;
+                size_t below = std::popcount(present[word] & ((std::uint64_t(1) << (b & 63)) - 1));
+                for (size_t w = 0; w < word; w++) {
+                    below += std::popcount(present[w]);
+                }
+                return below;
+            }
+            bool contains(unsigned char b) const { return (present[b >> 6] >> (b & 63)) & 1; }
+        };
+
+        ValueCount only; // The successor while there is at most one (count 0 while there is none)
+        std::uint32_t totalWeight; // Sum of all counts
+        Spread* spread; // The successors once there are two or more, nullptr before
+        std::pmr::memory_resource* resource; // Where spread is allocated
+
+        // Allocate a Spread from the resource, empty or as a copy of other
+        Spread* newSpread(const Spread* other = nullptr) {
+            void* memory = resource->allocate(sizeof(Spread), alignof(Spread));
+            return other ? new (memory) Spread(*other, resource) : new (memory) Spread(resource);
+        }
+
+        // Destroy the Spread, if any, and return its memory to the resource
+        void deleteSpread() {
+            if (spread) {
+                spread->~Spread();
+                resource->deallocate(spread, sizeof(Spread), alignof(Spread));
+                spread = nullptr;
+            }
+        }
+
+    public:
+        SuccessorList() : only(0, 0), totalWeight(0), spread(nullptr), resource(std::pmr::get_default_resource()) {}
+
+        /**
+         * @brief Start the list with one value (count 1)
+         * @param resource Where the list allocates once it has two successors (the tree's node arena);
+         * copies use the default heap
+         */
+        explicit SuccessorList(char v, std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+            : only(v, 1), totalWeight(1), spread(nullptr), resource(resource) {}
+
+        SuccessorList(const SuccessorList & other)
+            : only(other.only), totalWeight(other.totalWeight), spread(nullptr), resource(std::pmr::get_default_resource()) {
+            if (other.spread) {
+                spread = newSpread(other.spread);
+            }
+        }
+        // Like a pmr container, an assigned-to list keeps its own resource
+        SuccessorList & operator=(const SuccessorList & other) {
+            if (this != &other) {
+                deleteSpread();
+                only = other.only;
+                totalWeight = other.totalWeight;
+                if (other.spread) {
+                    spread = newSpread(other.spread);
+                }
+            }
+            return *this;
+        }
+        SuccessorList(SuccessorList && other) noexcept
+            : only(other.only), totalWeight(other.totalWeight), spread(other.spread), resource(other.resource) {
+            other.spread = nullptr;
+        }
+        SuccessorList & operator=(SuccessorList && other) {
+            if (resource != other.resource) {
+                return *this = static_cast<const SuccessorList &>(other); // The Spread belongs to the other resource
+            }
+            if (this != &other) {
+                deleteSpread();
+                only = other.only;
+                totalWeight = other.totalWeight;
+                spread = other.spread;
+                other.spread = nullptr;
+            }
+            return *this;
+        }
+        ~SuccessorList() {
+            deleteSpread();
+        }
+
+        /**
+         * @brief Record one more association with v: increment its count, or add it with count 1
+         * @param v The value that followed the key
+         */
+        void add(char v) {
+            totalWeight++;
+            if (!spread) {
+                if (only.count == 0 || only.value == v) {
+                    only.value = v;
+                    only.count++;
+                    return;
+                }
+                // A second distinct successor: move the first one into a Spread
+                spread = newSpread();
+                spread->present[static_cast<unsigned char>(only.value) >> 6] |= std::uint64_t(1) << (static_cast<unsigned char>(only.value) & 63);
+                spread->value_count.push_back(only);
+            }
+            spread->sampling.invalidate(); // The distribution changed
+            unsigned char b = static_cast<unsigned char>(v);
+            size_t index = spread->rank(b);
+            if (spread->contains(b)) {
+                spread->value_count[index].count++;
+            } else {
+                spread->present[b >> 6] |= std::uint64_t(1) << (b & 63);
+                spread->value_count.insert(spread->value_count.begin() + index, ValueCount(v, 1));
+            }
+        }
+
+        /**
+         * @brief Build the structure the given sampler needs, if the counts changed since it was last built
+         * @param sampler The sampler that will be used
+         */
+        void finalize(SamplerKind sampler = ALIAS_SAMPLER) {
+            if (spread) {
+                spread->sampling.finalize(sampler, spread->value_count.data(), spread->value_count.size(), totalWeight);
+            }
+        }
+
+        /**
+         * @brief Get a value randomly, weighted by its count.
+         * @param rand_num_gen The random number generator of the calling tree
+         * @param sampler Which sampler to use (see SamplerKind)
+         * @return char value
+         */
+        template <typename Generator>
+        char sample(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            return valueAt(sampleIndex(rand_num_gen, sampler));
+        }
+
+        /**
+         * @brief Like sample(), but return the position of the chosen value (see valueAt())
+         */
+        template <typename Generator>
+        size_t sampleIndex(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            if (!spread) {
+                return 0; // Nothing to choose from
+            }
+            return spread->sampling.sampleIndex(rand_num_gen, sampler, spread->value_count.data(), spread->value_count.size(), totalWeight);
+        }
+
+        const char & valueAt(size_t i) const { return spread ? spread->value_count[i].value : only.value; }
+        std::size_t size() const { return spread ? spread->value_count.size() : (only.count > 0 ? 1 : 0); }
+        const ValueCount* begin() const { return spread ? spread->value_count.data() : &only; }
+        const ValueCount* end() const { return begin() + size(); }
+};
+
+/**
+ * @class FrozenModel
+ * @brief A read-only copy of a finished model, packed into a few flat arrays.
+ *
+ * keys is a complete binary search tree in Eytzinger (breadth-first) order: keys[1] is the root and the children
+ * of keys[i] are keys[2i] and keys[2i + 1], so there are no node pointers or heights, the top levels share a few
+ * cache lines, and a lookup is a branchless descent that prefetches the keys two levels down.
+ * In-order traversal of that implicit tree visits the keys sorted, which display() relies on.
+ *
+ * The successors of keys[i] are values[successorStart[i] .. successorStart[i + 1]), and cumulativeCounts holds
+ * their running count within that range (the last one is the total). Sampling draws a number below the total and
+ * finds the first running count above it with a branchless binary search, so no per-key allocation or sampling
+ * structure remains.
+ *
+ * @tparam KeyType The data type of the keys (views such as CorpusKey stay valid only as long as what they view).
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename KeyType, typename ValueType>
+class FrozenModel {
+    private:
+        std::vector<KeyType> keys; // Eytzinger order, from index 1 (keys[0] is unused)
+        std::vector<std::uint32_t> successorStart; // Index of the first successor of each key, plus one past the end (from index 1)
+        std::vector<ValueType> values; // The successors of every key, one after the other
+        std::vector<std::uint32_t> cumulativeCounts; // Running count of each successor within its key's range
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
+
+        /**
+         * @brief Draw a successor of keys[key_index], weighted by the count
+         */
+        ValueType sample(std::size_t key_index) {
+            std::size_t index = successorStart[key_index];
+            std::size_t length = successorStart[key_index + 1] - index;
+            if (length == 1) {
+                return values[index]; // Nothing to choose from
+            }
+            const std::uint32_t* sums = cumulativeCounts.data();
+            std::uniform_int_distribution<std::uint32_t> dist(0, sums[index + length - 1] - 1);
+            std::uint32_t randNum = dist(rand_num_gen);
+            // Branchless binary search: the answer stays in [index, index + length)
+            for (; length > 1; ) {
+                std::size_t half = length / 2;
+                index = (sums[index + half - 1] <= randNum) ? index + half : index;
+                length -= half;
+            }
+            return values[index];
+        }
+
+        /**
+         * @brief Assign the sorted entries to Eytzinger positions by an in-order walk of the implicit tree
+         * @param order order[i] is set to the sorted index of the key at position i
+         * @param next The next sorted index to place
+         */
+        static std::size_t placeInOrder(std::vector<std::size_t> & order, std::size_t i, std::size_t next) {
+            if (i < order.size()) {
+                next = placeInOrder(order, 2 * i, next);
+                order[i] = next++;
+                next = placeInOrder(order, 2 * i + 1, next);
+            }
+            return next;
+        }
+
+        /**
+         * @brief Position of the first key not less than k, or 0 if every key is less
+         */
+        std::size_t lowerBound(const KeyType & k) const {
+            std::size_t n = keys.size() - 1;
+            std::size_t i = 1;
+            while (i <= n) {
+#if defined(__GNUC__)
+                __builtin_prefetch(keys.data() + std::min(4 * i, n)); // The 4 grandchildren share a cache line or two
+#endif
+                i = 2 * i + (keys[i] < k); // Go right past keys smaller than k, without a branch
+            }
+            // The path ends below the answer: undo the trailing right turns, then the last left turn
+            return i >> (std::countr_one(i) + 1);
+        }
+
+        /**
+         * @brief Display the subtree rooted at position i in order
+         */
+        void display(std::size_t i) const {
+            if (i < keys.size()) {
+                display(2 * i);
+                std::cout << "Key: \'" << keys[i] << "\'\n";
+                std::uint32_t previous = 0;
+                for (std::uint32_t j = successorStart[i]; j < successorStart[i + 1]; j++) {
+                    std::cout << "[Value: \'" << values[j] << "\', Count: \'" << cumulativeCounts[j] - previous << "\'] ";
+                    previous = cumulativeCounts[j];
+                }
+                std::cout << std::endl;
+                std::cout << std::endl;
+                display(2 * i + 1);
+            }
+        }
+
+    public:
+        /**
+         * @brief Copy a model (anything whose forEach(visit) yields keys in ascending order) into the flat arrays;
+         * the model is only read
+         * @throws std::runtime_error if the model has more keys or successors than 32-bit positions can hold
+         */
+        template <typename Model>
+        explicit FrozenModel(const Model & model) {
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+
+            std::vector<std::pair<KeyType, const SuccessorList<ValueType>*>> entries;
+            std::size_t successorTotal = 0;
+            model.forEach([&](const KeyType & key, const SuccessorList<ValueType> & successors) {
+                entries.emplace_back(key, &successors);
+                successorTotal += successors.size();
+            });
+            // Successor and key positions are stored in 32 bits
+            if (entries.size() > std::numeric_limits<std::uint32_t>::max() || successorTotal > std::numeric_limits<std::uint32_t>::max()) {
+                std::cerr << "Model too large to freeze: " << entries.size() << " keys, " << successorTotal << " successors" << std::endl;
+                throw std::runtime_error("Model too large to freeze");
+            }
+            // AVLTree and BPlusTree visit their keys in order, so entries is already sorted
+
+            std::vector<std::size_t> order(entries.size() + 1);
+            placeInOrder(order, 1, 0);
+
+            keys.reserve(entries.size() + 1);
+            successorStart.reserve(entries.size() + 2);
+            values.reserve(successorTotal);
+            cumulativeCounts.reserve(successorTotal);
+            keys.emplace_back();
+            successorStart.push_back(0);
+            for (std::size_t i = 1; i < order.size(); i++) {
+                const auto & [key, successors] = entries[order[i]];
+                keys.push_back(key);
+                successorStart.push_back(static_cast<std::uint32_t>(values.size()));
+                std::uint32_t runningCount = 0;
+                for (const auto & vc : *successors) {
+                    runningCount += vc.count;
+                    values.push_back(vc.value);
+                    cumulativeCounts.push_back(runningCount);
+                }
+            }
+            successorStart.push_back(static_cast<std::uint32_t>(values.size()));
+        }
+
+        std::size_t size() const { return keys.size() - 1; }
+
+        /**
+         * @brief Bytes held by the arrays (not counting what the keys or values point to)
+         */
+        std::size_t memoryBytes() const {
+            return keys.capacity() * sizeof(KeyType) + successorStart.capacity() * sizeof(std::uint32_t)
+                 + values.capacity() * sizeof(ValueType) + cumulativeCounts.capacity() * sizeof(std::uint32_t);
+        }
+
+        /**
+         * @brief Get a random successor of k, weighted by the count
+         * @param Keytype & k
+         * @return ValueType value
+         * @throws std::runtime_error if the key is not found
+         */
+        ValueType getRandVal(const KeyType & k) {
+            std::size_t found = lowerBound(k);
+            if (found == 0 || k < keys[found]) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
+            }
+            return sample(found);
+        }
+
+        /**
+         * @brief Display the keys in order (an in-order walk of the implicit tree) and their values with counts
+         */
+        void display() const {
+            display(1);
+        }
+};
+
+/**
+ * @class SlabArena
+ * @brief Node arena for AVLTree: a bump allocator over large slabs, with free lists for recycled blocks.
+ *
+ * Blocks are carved from 2 MiB slabs (rounded up to 16 bytes); a released block goes on the free list of its
+ * size and is handed out again before the slab is bumped, so removed nodes and outgrown successor vectors are
+ * reused. Slabs are only returned when the arena is destroyed, which costs one release per slab.
+ *
+ * With huge pages, slabs are aligned to 2 MiB and marked MADV_HUGEPAGE so the kernel can back each one with
+ * a single transparent huge page (one TLB entry instead of 512); elsewhere the hint is ignored.
+ * It is a std::pmr::memory_resource, so the successor vectors of the nodes can allocate from it too.
+ */
+class SlabArena : public std::pmr::memory_resource {
+    private:
+        static constexpr std::size_t SLAB_BYTES = std::size_t(2) << 20; // The size of a huge page on x86-64
+        static constexpr std::size_t GRANULE = 16; // Block sizes are multiples of this (and aligned to it)
+        static constexpr std::size_t FREE_LIST_CLASSES = 256; // Blocks up to 4 KiB are recycled
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        std::vector<std::pair<void*, std::size_t>> slabs; // Every slab (and oversized block) with its size
+        char* cursor = nullptr; // Next free byte of the current slab
+        char* slabEnd = nullptr;
+        FreeBlock* freeLists[FREE_LIST_CLASSES] = {}; // Released blocks, by size / GRANULE - 1
+        bool hugePages;
+
+        // Get a new region from the system, aligned to a slab so a huge page can back it
+        void* newSlab(std::size_t bytes) {
+            void* slab = ::operator new(bytes, std::align_val_t(hugePages ? SLAB_BYTES : GRANULE));
+#if CORPUS_HAS_MMAP && defined(MADV_HUGEPAGE)
+            if (hugePages) {
+                madvise(slab, bytes, MADV_HUGEPAGE); // A hint: without THP support the slab keeps normal pages
+            }
+#endif
+            slabs.emplace_back(slab, bytes);
+            return slab;
+        }
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            bytes = (std::max<std::size_t>(bytes, 1) + GRANULE - 1) & ~(GRANULE - 1);
+            std::size_t sizeClass = bytes / GRANULE - 1;
+            if (alignment <= GRANULE && sizeClass < FREE_LIST_CLASSES && freeLists[sizeClass] != nullptr) {
+                FreeBlock* block = freeLists[sizeClass];
+                freeLists[sizeClass] = block->next;
+                return block;
+            }
+            if (bytes > SLAB_BYTES / 4) {
+                return newSlab(bytes); // Too big to share a slab: it gets its own region
+            }
+            std::size_t align = std::max(alignment, GRANULE);
+            char* start = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(cursor) + align - 1) & ~(align - 1));
+            if (cursor == nullptr || start + bytes > slabEnd) {
+                cursor = static_cast<char*>(newSlab(SLAB_BYTES));
+                slabEnd = cursor + SLAB_BYTES;
+                start = cursor;
+            }
+            cursor = start + bytes;
+            return start;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            bytes = (std::max<std::size_t>(bytes, 1) + GRANULE - 1) & ~(GRANULE - 1);
+            std::size_t sizeClass = bytes / GRANULE - 1;
+            if (alignment <= GRANULE && sizeClass < FREE_LIST_CLASSES) {
+                freeLists[sizeClass] = new (p) FreeBlock{freeLists[sizeClass]};
+            }
+            // Larger blocks stay in their slab until the arena is destroyed
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override {
+            return this == &other;
+        }
+
+    public:
+        /**
+         * @param useHugePages Align slabs to 2 MiB and ask for transparent huge pages
+         */
+        explicit SlabArena(bool useHugePages = false) : hugePages(useHugePages) {}
+
+        ~SlabArena() {
+            for (const auto & [slab, bytes] : slabs) {
+                ::operator delete(slab, std::align_val_t(hugePages ? SLAB_BYTES : GRANULE));
+            }
+        }
+
+        SlabArena(const SlabArena &) = delete;
+        SlabArena & operator=(const SlabArena &) = delete;
+
+        // Every block lives in a slab: when the arena goes away, objects need no destructor of their own
+        static constexpr bool RELEASES_ALL = true;
+
+        std::size_t slabCount() const { return slabs.size(); }
+};
+
+/**
+ * @class HeapArena
+ * @brief Node arena for AVLTree that allocates every block from the global heap (new / delete), one by one
+ */
+class HeapArena : public std::pmr::memory_resource {
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            ::operator delete(p, bytes, std::align_val_t(alignment));
+        }
+        bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override {
+            return this == &other;
+        }
+
+    public:
+        explicit HeapArena(bool = false) {} // Huge pages do not apply
+
+        // Blocks must be released one by one
+        static constexpr bool RELEASES_ALL = false;
+};
+
+/**
+ * @class AVLTree
+ * @brief Implements a self-balancing Binary Search Tree using the AVL Tree algorithm.
+ *
+ * The AVLTree class provides an efficient binary search tree where the tree automatically balances itself
+ * after each insertion to ensure that it remains balanced. This balance ensures that the operations
+ * like insertion, deletion, and lookup are performed in O(log n) time. The AVLTree maintains the height-balanced
+ * property, which states that the height difference between the left and right subtree of any node is no more than 1.
+ *
+ * The class supports operations such as insertion and in-order traversal. Balancing is performed using 
+ * rotations (single and double), and the height of each node is updated during insertion to maintain balance.
+ *
+ * Nodes and their successor lists are allocated from an Arena (SlabArena by default, HeapArena for one heap
+ * block each).
+ *
+ * @tparam Comparable The data type to store in the tree, which must support comparison operators.
+ * @tparam Arena A std::pmr::memory_resource constructible from a huge-pages flag, with a RELEASES_ALL constant
+ */
+template <typename KeyType, typename ValueType, typename Arena = SlabArena>
+class AVLTree {
+    private:
+        /**
+         * @struct AvlNode
+         * @brief Represents a node in the AVL Tree.
+         *
+         * The AvlNode struct is used to store individual elements of the AVL Tree. Each node contains an element (the key),
+         * pointers to its left and right children, its height within the tree and the size of its subtree.
+         * For string-like keys it also caches the first 8 key bytes as an integer (see KeyPrefix), so most comparisons
+         * on the way down never read the key bytes.
+         */
+        struct AvlNode {
+            std::uint64_t prefix; // KeyPrefix of the key (0 if the key type has none)
+            KeyType key; //Any comparable types: int, float, double, char, std::string, or any custom comparable class or struct
+            SuccessorList<ValueType> value_count; // Values and their counts
+            AvlNode *left;
+            AvlNode *right;
+            int height;
+            int count; // Number of nodes in the subtree rooted here, for O(1) size() and O(log n) select()/rank()
+
+        /**
+         * @brief Constructs an AVL Node.
+         * @param ele The element (key) to store in the node.
+         * @param lt Pointer to the left child node (defaults to nullptr).
+         * @param rt Pointer to the right child node (defaults to nullptr).
+         * @param h Height of the node (defaults to 0).
+         */
+        AvlNode(const KeyType & key, std::uint64_t prefix, const ValueType & value, std::pmr::memory_resource * resource, AvlNode *lt = nullptr, AvlNode *rt = nullptr, int h = -1)
+                : prefix(prefix), key(key), value_count(value, resource), left(lt), right(rt), height(h), count(1) {} //Push the value a initalize its count
+        
+        };
+
+        /**
+         * @brief Where the nodes and their successor lists are allocated
+         */
+        Arena arena;
+
+        /**
+         * @brief True if the arena frees every node at once and no node holds memory from elsewhere
+         * (the successor lists use the arena, so only the key and value types matter)
+         */
+        static constexpr bool ARENA_RELEASES_NODES = Arena::RELEASES_ALL &&
+            std::is_trivially_destructible_v<KeyType> && std::is_trivially_destructible_v<ValueType>;
+        
+        /**
+         * @brief Pointer to the root node of the AVLTree
+         */
+        AvlNode *root; 
+
+        /**
+         * @brief Allocate and construct a node in the arena
+         */
+        AvlNode* newNode(const KeyType & k, std::uint64_t p, const ValueType & v) {
+            void* memory = arena.allocate(sizeof(AvlNode), alignof(AvlNode));
+            return new (memory) AvlNode(k, p, v, &arena);
+        }
+
+        /**
+         * @brief Three-way compare of a key (with its precomputed prefix) against the key of node t
+         *
+         * Different prefixes decide the order with one integer compare; the full key compare only runs when they tie.
+         * Key types without <=> fall back to their operator== and operator<.
+         *
+         * @return less, equivalent or greater, as k compares to t->key
+         */
+        static std::weak_ordering compareKey(const KeyType & k, std::uint64_t p, const AvlNode *t) {
+            if constexpr (KeyPrefix<KeyType>::CACHED) {
+                if (p != t->prefix) {
+                    return p <=> t->prefix;
+                }
+            }
+            return std::compare_weak_order_fallback(k, t->key);
+        }
+
+        /**
+         * @brief Destroy a node and give its memory back to the arena
+         */
+        void deleteNode(AvlNode *t) {
+            t->~AvlNode();
+            arena.deallocate(t, sizeof(AvlNode), alignof(AvlNode));
+        }
+
+        /**
+         * @brief Function to properly delete a node from memory
+         */
+        void clear(AvlNode *t){
+            if (t != nullptr){
+                clear(t->left);
+                clear(t->right);
+                deleteNode(t);
+                t = nullptr;
+            }
+        }
+        /**
+         * @brief Private function to return height of a node
+         * @param AvlNode * t
+         * @return int height, -1 if t is nullptr
+         */
+        int height(AvlNode *t) const {
+            if (t == nullptr) {
+                return -1;
+            }
+            else {
+                return t->height;
+            }
+        }
+        /**
+         * @brief Private function to return the size of the subtree rooted at t (number of nodes), read from the node
+         * Function is marked as const to ensure no modification is performed in the Tree structure
+         * @param AvlNode * t
+         * @return int size, 0 if t is nullptr
+         */
+        int size(AvlNode *t) const {
+            if (t == nullptr) {
+                return 0;
+            }
+            else {
+                return t->count;
+            }
+        }
+
+        /**
+         * @brief Recompute the height and subtree size of t from its children
+         * @param AvlNode * t (not nullptr)
+         */
+        void update(AvlNode *t) {
+            t->height = std::max(height(t->left), height(t->right)) + 1;
+            t->count = size(t->left) + size(t->right) + 1;
+        }
+
+        /**
+         * @brief Private function to check if the avl tree rooted at node t
+         * Function is marked as const to ensure no modification is performed on the tree structure
+         * @param AvlNode t
+         * @return True if empty, False if not empty
+         */
+        bool empty(AvlNode * t) const{
+            if (t == nullptr){
+                return true;
+            }
+            else return false;
+        }
+        static const int ALLOWED_IMBALANCE = 1;
+        /**
+         * @brief Balances the subtree rooted at the given node.
+         * 
+         * This function checks the balance factor of the node and applies the appropriate rotations (single or double)
+         * to ensure that the subtree rooted at the given node is height-balanced.
+         *
+         * @param t Reference to the pointer to the root of the subtree to be balanced.
+         */
+        void balance(AvlNode * & t){
+            if (t == nullptr){
+                return;
+            }
+            else if ((height(t->left) - height(t->right)) > ALLOWED_IMBALANCE){
+                if(height(t->left->left) >= height(t->left->right)){
+                    singleWithLeftChild(t);
+                }
+                else doubleWithLeftChild(t);
+            }
+            else if ((height(t->right) - height(t->left)) > ALLOWED_IMBALANCE){
+                if(height(t->right->right) >= height(t->right->left)){
+                    singleWithRightChild(t);
+                }
+                else doubleWithRightChild(t);
+            }
+
+            update(t); //Update the height and subtree size
+
+        }
+
+        /**
+         * @brief Performs a single rotation for a root node with the left child that has a left-heavy subtree.
+         * Update the height and subtree size
+         * Update root node
+         * @param k Reference to the pointer to the root of the subtree to rotate.
+         */
+        void singleWithLeftChild(AvlNode* & k){
+            AvlNode * temp = k->left; //create a temp left child of k 
+            k->left = temp->right; //move right child of temp to k left
+            temp->right = k; //make k as temp right child
+            update(k); //update the height and size of k, now a child of temp
+            update(temp); //then of temp
+            k = temp; //update root node of the subtree
+        }
+        /**
+         * @brief Performs a single rotation for a root node with the right child that has right-heavy subtree.
+         * Update the height and subtree size
+         * Update root node
+         * @param k Reference to the pointer to the root of the subtree to rotate.
+         */
+        void singleWithRightChild(AvlNode* & k){
+            AvlNode * temp = k->right; //create a temp left child of k 
+            k->right = temp->left; //move right child of temp to k left
+            temp->left = k; //make k as temp right child
+            update(k); //update the height and size of k, now a child of temp
+            update(temp); //then of temp
+            k = temp; //update root node of the subtree
+        }
+
+        /**
+         * @brief Performs a double rotation for a root node with the left child that has right heavy subtree
+         * Update the height and subtree size
+         * Update root node
+         * @param k Reference to the pointer to the root of the subtree to rotate.
+         */
+        void doubleWithLeftChild(AvlNode* & k){
+            singleWithRightChild(k->left); //First rotation for the left node of k
+            singleWithLeftChild(k); //Second rotation for k itseft
+        }
+
+        /**
+         * @brief Performs a double rotation for a root node with the right child that has left heavy subtree
+         * Update the height and subtree size
+         * Update root node
+         * @param k Reference to the pointer to the root of the subtree to rotate.
+         */
+        void doubleWithRightChild(AvlNode* & k){
+            singleWithLeftChild(k->right); //First rotation for the right node of k
+            singleWithRightChild(k); //Second rotation for k itseft
+        }
+
+        /**
+        * @brief Recursively inserts a new key and value into the subtree rooted at the given node.
+        *
+        * This function inserts the key and its associated value into the correct position in the subtree while maintaining the
+        * binary search tree property. If the key already exists, it updates the value_count vector by adding or updating the value.
+        * After insertion, the function calls `balance` to ensure that the subtree remains balanced.
+        *
+        * @param KeyType k The key to insert.
+        * @param uint64_t p The KeyPrefix of k
+        * @param ValueType v The associated value for the key.
+        * @param AvlNode t Reference to the pointer to the root of the subtree in which to insert the key-value pair.
+        */
+        void insert(const KeyType & k, std::uint64_t p, const ValueType & v, AvlNode* & t) {
+            if (t == nullptr) {
+                // If no node exists, create a new node with the key and value
+                t = newNode(k, p, v);
+            }
+            else if (std::weak_ordering order = compareKey(k, p, t); order < 0) {
+                insert(k, p, v, t->left);  // Insert into the left subtree
+            }
+            else if (order > 0) {
+                insert(k, p, v, t->right);  // Insert into the right subtree
+            }
+            // If the key already exists, increment the value's count or add it with count 1
+            else {
+                t->value_count.add(v);
+                return; // The shape did not change
+            }
+            balance(t);  // Balance the subtree after insertion (height updated here)
+        }
+
+        /**
+         * @brief Find the minimum node in a subtree (used for node replacement during deletion)
+        */
+        AvlNode* findMin(AvlNode* t) const {
+            if (t == nullptr) return nullptr;
+            if (t->left == nullptr) return t;
+            return findMin(t->left);
+        }
+
+        /**
+        * @brief Recursively removes a node with the specified key from the subtree rooted at the given node.
+        *
+        * This function removes the node with the given key from the subtree while maintaining the binary search tree property.
+        * If the key exists in the tree, the node is removed, and the subtree is rebalanced if necessary.
+        * If the key does not exist, an error condition occurs.
+        * After removal, the function calls `balance` to ensure that the subtree remains balanced.
+        *
+        * @param KeyType k A reference to the key to remove from the AVL tree.
+        * @param uint64_t p The KeyPrefix of k
+        * @param AvlNode* & t A pointer reference to the root of the subtree from which to remove the key.
+        * @throw std::runtime_error if the key does not exist in the tree.
+        */
+        void remove(const KeyType & k, std::uint64_t p, AvlNode * & t){
+            if (t == nullptr) {
+                throw std::runtime_error("Error: Key not found");  // Error if key does not exist
+            }
+
+            std::weak_ordering order = compareKey(k, p, t);
+            if(order < 0){
+                remove(k, p, t->left); //key is in the left subtree
+            }
+            else if(order > 0){
+                remove(k, p, t->right); //key is in the right subtree
+            }
+            //Key found
+            else {
+                //Node has 2 children
+                if(t->left != nullptr && t->right != nullptr){
+                    AvlNode* minNode = findMin(t->right); //find the minimum node of the right subtree
+                    
+                    t->key = minNode->key; //transfer the key
+                    t->prefix = minNode->prefix; //and its cached prefix
+                    t->value_count = minNode->value_count; //transfer the array
+                    remove(minNode->key, minNode->prefix, t->right); //remove the minNode from the right subtree
+                }
+                //Node has one or no child
+                else{
+                    AvlNode* oldNode = t;
+                    //Promote the child (if there is)
+                    if(t->left != nullptr){
+                        t = t->left; //promote left child
+                    }
+                    else{
+                        t = t->right; //promote right child
+                    }
+                    deleteNode(oldNode);
+                }
+            }
+            //END ALL Checks//
+                balance(t);  //Balance the tree
+        }
+
+
+        /**
+         * @brief Private method that traverses the subtree rooted at root to find an element of key k 
+         * Return the element (AvlNode)
+         * Function is marked as const -> ensure no modification
+         * @param KeyType & k: Reference of a key
+         * @return pointer to the AvlNode: element. nullptr if no key found
+         */
+        AvlNode* find(const KeyType & k, AvlNode* root) const {
+            std::uint64_t p = KeyPrefix<KeyType>::of(k); // Computed once for the whole descent
+            while (root != nullptr) {
+                std::weak_ordering order = compareKey(k, p, root);
+                if (order == 0) {
+                    return root; //return if key is found
+                }
+                root = (order < 0) ? root->left : root->right; //Search left or right
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief Private method that finds the node holding the i-th smallest key (0-based) of the subtree rooted at t
+         * Goes left or right by the size of the left subtree, so it visits one node per level
+         * @param int i: Index into the sorted keys of the subtree, in [0, size(t))
+         * @return pointer to the AvlNode
+         */
+        AvlNode* select(int i, AvlNode* t) const {
+            while (true) {
+                int leftSize = size(t->left);
+                if (i < leftSize) {
+                    t = t->left;
+                }
+                else if (i > leftSize) {
+                    i -= leftSize + 1; // Skip the left subtree and t itself
+                    t = t->right;
+                }
+                else return t;
+            }
+        }
+
+        /**
+         * @brief Private method that counts the keys smaller than k in the subtree rooted at t
+         * @param KeyType & k: Reference of a key (it does not have to be in the tree)
+         * @return int number of smaller keys
+         */
+        int rank(const KeyType & k, AvlNode* t) const {
+            std::uint64_t p = KeyPrefix<KeyType>::of(k);
+            int smaller = 0;
+            while (t != nullptr) {
+                std::weak_ordering order = compareKey(k, p, t);
+                if (order > 0) {
+                    smaller += size(t->left) + 1; // The left subtree and t are smaller
+                    t = t->right;
+                }
+                else if (order < 0) {
+                    t = t->left;
+                }
+                else return smaller + size(t->left);
+            }
+            return smaller;
+        }
+
+        /**
+         * @brief Private method that traverses the subtree rooted at the given node.
+         * Recursively performs an in-order traversal of the tree.
+         * Displays keys, values, and their counts in sorted order (left - root - right).
+         * @param AvlNode root: Pointer to the root of the subtree to display.
+         */
+        void display(AvlNode* root) const {
+            if (root != nullptr) {
+                display(root->left);  // Traverse the left subtree
+
+                // Display the key
+                std::cout << "Key: \'" << root->key << "\' -> ";
+
+                // Display all values and their counts for this key
+                for (const auto& vc : root->value_count) {
+                    std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
+                }
+                std::cout << std::endl;
+
+                display(root->right);  // Traverse the right subtree
+            }
+        }
+
+        /**
+         * @brief Private method to seed the random generator
+         * Encapsulate the seeding method to avoid manipulation
+         * The function is marked as const to ensure no modification if perform on the Tree structure
+         */
+        /* void initializeRandomGenerator() const {
+            std::srand(static_cast<unsigned>(std::time(NULL))); // Seed the random number generator globally
+        } */
+
+        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
+        SamplerKind sampler = ALIAS_SAMPLER; // How getRandVal picks a weighted value
+    
+        /**
+         * @brief Function to get a value of a given key randomly. 
+         * Value that has a higher count will has a higher chance of being returned.
+         * 
+         * @param Keytype & k key value
+         * @param AvlNode * root: Pointer to the root Node of the substree
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k, AvlNode * root) {
+            AvlNode* node = find(k, this->root);
+            if (node == nullptr) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
+            }
+            return node->value_count.sample(rand_num_gen, sampler); // Weighted by the count of each value
+        }
+
+        /**
+         * @brief Build the sampling structure of every node in the subtree rooted at t
+         * @param AvlNode * t
+         */
+        void finalize(AvlNode * t) {
+            if (t != nullptr) {
+                finalize(t->left);
+                t->value_count.finalize(sampler);
+                finalize(t->right);
+            }
+        }
+
+        /**
+         * @brief Call visit(key, successors) for every node in the subtree rooted at t, in key order
+         * @param Visitor & visit
+         * @param AvlNode * t
+         */
+        template <typename Visitor>
+        void forEach(Visitor & visit, AvlNode * t) const {
+            if (t != nullptr) {
+                forEach(visit, t->left);
+                visit(t->key, t->value_count);
+                forEach(visit, t->right);
+            }
+        }
+
+
+    public:
+        /**
+         * @brief Constructs an empty AVL Tree.
+         * @param hugePages Ask the arena to back its slabs with transparent huge pages
+         */
+        explicit AVLTree(bool hugePages = false) : arena(hugePages), root(nullptr){
+            //Change the seed everytime the new AVLTree Object is created
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+        }
+
+        /**
+         * @brief Constructs an empty AVL Tree.
+         */
+        ~AVLTree() {
+            if constexpr (!ARENA_RELEASES_NODES) {
+                clear(root); // Otherwise the arena releases all nodes at once, slab by slab
+            }
+        }
+
+        // PUBLIC METHOD //
+        /**
+         * @brief Function that return number of keys in the Avl Tree, in O(1)
+         */
+        int size()const;
+
+        /**
+         * @brief Function that return True if the tree is empty, and False otherwise
+         */
+        bool empty() const;
+
+        /**
+         * @brief Inserts an element into the AVL Tree.
+         *
+         * This function inserts the element into the AVL Tree, ensuring that the tree remains balanced after insertion.
+         * The element is placed based on binary search tree insertion rules.
+         *
+         * @param KeyType k The key to insert into the tree.
+         * @param ValueType v The value of the key
+         */
+        void insert(const KeyType & k, const ValueType & v);
+
+        /**
+         * @brief Remove an element from the AVL Tree
+         * 
+         * This function remove the element in the AVL Tree with the given key
+         * 
+         * @param KeyType k
+         */
+        void remove(const KeyType & k);
+
+        /**
+         * @brief Public method to find an element with a given key and print it's value_count.
+         * This function is marked as const to ensure no modification is performed on the AvlTree structure
+         * 
+         * @param Keytype k
+         */
+        void find(const KeyType & k) const;
+
+        /**
+         * @brief Public method to check whether a key is in the tree, without printing anything
+         * @param Keytype & k
+         * @return True if the key is found
+         */
+        bool contains(const KeyType & k) const;
+
+        /**
+         * @brief Public method to get the i-th smallest key (0-based) in O(log n).
+         * select(rand() % size()) picks a uniformly random key, and select(p * size() / 100) the p-th percentile.
+         * @param int i
+         * @return const KeyType & the key
+         * @throw std::runtime_error if i is not in [0, size())
+         */
+        const KeyType & select(int i) const;
+
+        /**
+         * @brief Public method to count the keys smaller than k in O(log n) (k need not be in the tree).
+         * For a key in the tree this is its index, so select(rank(k)) == k.
+         * @param Keytype & k
+         * @return int rank
+         */
+        int rank(const KeyType & k) const;
+
+        /**
+         * @brief Public method to get a random value weighted by the count
+         * Function is marked as const to ensure no modification is performed on the Tree Structure
+         * @param Keytype & k
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k);
+
+        /**
+         * @brief Public method like getRandVal, in one search, that reports a missing key instead of throwing
+         * (for callers that handle dead ends, such as --restart)
+         * @param Keytype & k
+         * @param ValueType & value Set to the random value if the key is found
+         * @return True if the key is found
+         */
+        bool tryGetRandVal(const KeyType & k, ValueType & value);
+
+        /**
+         * @brief Choose how getRandVal picks a weighted value (call before finalize())
+         */
+        void setSampler(SamplerKind kind) {
+            sampler = kind;
+        }
+
+        /**
+         * @brief Build the sampling structure (alias table or prefix sums) of every key once the tree is complete.
+         * Keys inserted into afterwards are rebuilt lazily by their next getRandVal().
+         */
+        void finalize();
+
+        /**
+         * @brief Call visit(key, successors) for every key of the tree, in key order
+         */
+        template <typename Visitor>
+        void forEach(Visitor visit) const;
+
+        /**
+         * @brief Copy the keys and successors into a read-only FrozenModel (the tree is unchanged)
+         */
+        FrozenModel<KeyType, ValueType> freeze() const;
+
+        /**
+         * @brief Public method that displays the AVL Tree in in-order traversal.
+         *
+         * This function prints the elements of the AVL Tree in sorted order by performing an in-order traversal.
+         */
+        void display() const;
+};
+
+//***IMPLEMENTATION OF PUBLIC METHOD***//
+// Implementation of public insert(key, value)
+template <typename KeyType, typename ValueType, typename Arena>
+void AVLTree<KeyType, ValueType, Arena>::insert(const KeyType & x, const ValueType & v) {
+    insert(x, KeyPrefix<KeyType>::of(x), v, this->root);
+}
+
+// Implementation of public size()
+template <typename KeyType, typename ValueType, typename Arena>
+int AVLTree<KeyType, ValueType, Arena>::size() const {
+    return size(this->root);
+}
+
+// Implementation of public empty()
+template <typename KeyType, typename ValueType, typename Arena>
+bool AVLTree<KeyType, ValueType, Arena>::empty() const {
+    return empty(this->root);
+}
+
+//Impletementation of public find(key)
+template <typename KeyType, typename ValueType, typename Arena>
+void AVLTree<KeyType, ValueType, Arena>::find(const KeyType & k) const {
+    AvlNode* node = find(k, this->root);
+    if (node == nullptr){
+        std::cout << "No element found" << std::endl;
+    }
+    else {
+        for(const auto & vc : node->value_count){
+            std::cout << "[Value: " << vc.value << ", Count: " << vc.count << "] " << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+//Implementation of public contains(key)
+template <typename KeyType, typename ValueType, typename Arena>
+bool AVLTree<KeyType, ValueType, Arena>::contains(const KeyType & k) const {
+    return find(k, this->root) != nullptr;
+}
+
+//Implementation of public select(i)
+template <typename KeyType, typename ValueType, typename Arena>
+const KeyType & AVLTree<KeyType, ValueType, Arena>::select(int i) const {
+    if (i < 0 || i >= size(this->root)) {
+        throw std::runtime_error("Index out of range");
+    }
+    return select(i, this->root)->key;
+}
+
+//Implementation of public rank(key)
+template <typename KeyType, typename ValueType, typename Arena>
+int AVLTree<KeyType, ValueType, Arena>::rank(const KeyType & k) const {
+    return rank(k, this->root);
+}
+
+//Implementation of public remove(key)
+template <typename KeyType, typename ValueType, typename Arena>
+void AVLTree<KeyType, ValueType, Arena>::remove(const KeyType & k){
+    try {
+        remove(k, KeyPrefix<KeyType>::of(k), this->root);  // Call private remove method
+        std::cout << "Remove successful" << std::endl;  // Print success message if no error occurs
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << std::endl;  // Handle error if key not found
+    }
+}
+
+//Implementation of public getRandVal(key)
+template <typename KeyType, typename ValueType, typename Arena>
+ValueType AVLTree<KeyType, ValueType, Arena>::getRandVal(const KeyType & k) {
+    return getRandVal(k,this->root);
+}
+
+//Implementation of public tryGetRandVal(key, value)
+template <typename KeyType, typename ValueType, typename Arena>
+bool AVLTree<KeyType, ValueType, Arena>::tryGetRandVal(const KeyType & k, ValueType & value) {
+    AvlNode* node = find(k, this->root);
+    if (node == nullptr) {
+        return false;
+    }
+    value = node->value_count.sample(rand_num_gen, sampler);
+    return true;
+}
+
+//Implementation of public finalize()
+template <typename KeyType, typename ValueType, typename Arena>
+void AVLTree<KeyType, ValueType, Arena>::finalize() {
+    finalize(this->root);
+}
+
+//Implementation of public forEach(visit)
+template <typename KeyType, typename ValueType, typename Arena>
+template <typename Visitor>
+void AVLTree<KeyType, ValueType, Arena>::forEach(Visitor visit) const {
+    forEach(visit, this->root);
+}
+
+//Implementation of public freeze()
+template <typename KeyType, typename ValueType, typename Arena>
+FrozenModel<KeyType, ValueType> AVLTree<KeyType, ValueType, Arena>::freeze() const {
+    return FrozenModel<KeyType, ValueType>(*this);
+}
+
+// Implementation of public display()
+template <typename KeyType, typename ValueType, typename Arena>
+void AVLTree<KeyType, ValueType, Arena>::display() const {
+    if (this->root == nullptr) {
+        std::cout << "The tree is empty" << std::endl;
+    } else {
+        display(this->root);
+        std::cout << std::endl;
+    }
+}
+
+/**
+ * @class BPlusTree
+ * @brief An ordered key-value store with wide nodes, as an alternative to AVLTree with the same interface.
+ *
+ * Every node holds up to MAX_KEYS sorted keys in one array, so a lookup touches about log_{MAX_KEYS/2}(n) nodes
+ * instead of log2(n), and the keys of a node sit in consecutive cache lines. Inner nodes only route; the
+ * SuccessorList of each key lives in the leaves, which are linked left to right for in-order walks.
+ * Inside a node the key is found by binary search with operator<, plus one equality check at the end.
+ *
+ * Nodes are split when they overflow and, on remove, refilled from a sibling or merged with it when they fall
+ * below half full.
+ *
+ * @tparam KeyType The data type of the keys, which must support operator<.
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename KeyType, typename ValueType>
+class BPlusTree {
+    private:
+        static constexpr int MAX_KEYS = 32; // 32 CorpusKeys fill 8 cache lines
+        static constexpr int MIN_KEYS = MAX_KEYS / 2; // Every node but the root keeps at least this many
+
+        /**
+         * @struct Node
+         * @brief What inner nodes and leaves share; arrays have one spare slot so a node can overflow before it splits
+         */
+        struct Node {
+            bool leaf;
+            int count; // Number of keys
+            KeyType keys[MAX_KEYS + 1];
+            explicit Node(bool isLeaf) : leaf(isLeaf), count(0) {}
+        };
+        struct Leaf : Node {
+            SuccessorList<ValueType> values[MAX_KEYS + 1]; // values[i] belongs to keys[i]
+            Leaf* next = nullptr; // The leaf to the right
+            Leaf() : Node(true) {}
+        };
+        struct Inner : Node {
+            Node* children[MAX_KEYS + 2]; // children[i] holds the keys in [keys[i - 1], keys[i])
+            Inner() : Node(false) {}
+        };
+
+        Node* root;
+        int keyCount; // Number of keys in the tree
+        SamplerKind sampler = ALIAS_SAMPLER; // How getRandVal picks a weighted value
+        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
+
+        static Leaf* asLeaf(Node* n) { return static_cast<Leaf*>(n); }
+        static Inner* asInner(Node* n) { return static_cast<Inner*>(n); }
+
+        // Index of the first key that is not less than k
+        static int lowerBound(const Node* n, const KeyType & k) {
+            return static_cast<int>(std::lower_bound(n->keys, n->keys + n->count, k) - n->keys);
+        }
+        // Index of the child of an inner node that may hold k: the number of keys <= k
+        static int childIndex(const Node* n, const KeyType & k) {
+            return static_cast<int>(std::upper_bound(n->keys, n->keys + n->count, k) - n->keys);
+        }
+
+        void clear(Node* n) {
+            if (n == nullptr) return;
+            if (n->leaf) {
+                delete asLeaf(n);
+            } else {
+                for (int i = 0; i <= n->count; i++) {
+                    clear(asInner(n)->children[i]);
+                }
+                delete asInner(n);
+            }
+        }
+
+        // The successors of k, or nullptr
+        SuccessorList<ValueType>* findValues(const KeyType & k) const {
+            Node* n = root;
+            if (n == nullptr) return nullptr;
+            while (!n->leaf) {
+                n = asInner(n)->children[childIndex(n, k)];
+            }
+            int i = lowerBound(n, k);
+            if (i < n->count && !(k < n->keys[i])) {
+                return &asLeaf(n)->values[i];
+            }
+            return nullptr;
+        }
+
+        Leaf* leftmostLeaf() const {
+            Node* n = root;
+            if (n == nullptr) return nullptr;
+            while (!n->leaf) {
+                n = asInner(n)->children[0];
+            }
+            return asLeaf(n);
+        }
+
+        /**
+         * @brief Insert into the subtree rooted at n
+         * @param separator Set to the first key of the new right node if n splits
+         * @return The new right node if n split, else nullptr
+         */
+        Node* insert(Node* n, const KeyType & k, const ValueType & v, KeyType & separator) {
+            if (n->leaf) {
+                Leaf* leaf = asLeaf(n);
+                int i = lowerBound(leaf, k);
+                if (i < leaf->count && !(k < leaf->keys[i])) {
+                    leaf->values[i].add(v); // The key already exists
+                    return nullptr;
+                }
+                for (int j = leaf->count; j > i; j--) {
+                    leaf->keys[j] = leaf->keys[j - 1];
+                    leaf->values[j] = std::move(leaf->values[j - 1]);
+                }
+                leaf->keys[i] = k;
+                leaf->values[i] = SuccessorList<ValueType>(v);
+                leaf->count++;
+                keyCount++;
+                if (leaf->count <= MAX_KEYS) return nullptr;
+
+                // Split: the upper half moves to a new leaf
+                Leaf* right = new Leaf();
+                int keep = leaf->count / 2;
+                for (int j = keep; j < leaf->count; j++) {
+                    right->keys[j - keep] = leaf->keys[j];
+                    right->values[j - keep] = std::move(leaf->values[j]);
+                }
+                right->count = leaf->count - keep;
+                leaf->count = keep;
+                right->next = leaf->next;
+                leaf->next = right;
+                separator = right->keys[0];
+                return right;
+            }
+
+            Inner* inner = asInner(n);
+            int i = childIndex(inner, k);
+            KeyType childSeparator;
+            Node* newChild = insert(inner->children[i], k, v, childSeparator);
+            if (newChild == nullptr) return nullptr;
+            for (int j = inner->count; j > i; j--) {
+                inner->keys[j] = inner->keys[j - 1];
+                inner->children[j + 1] = inner->children[j];
+            }
+            inner->keys[i] = childSeparator;
+            inner->children[i + 1] = newChild;
+            inner->count++;
+            if (inner->count <= MAX_KEYS) return nullptr;
+
+            // Split: the middle key moves up, the keys after it move to a new inner node
+            Inner* right = new Inner();
+            int middle = inner->count / 2;
+            separator = inner->keys[middle];
+            for (int j = middle + 1; j < inner->count; j++) {
+                right->keys[j - middle - 1] = inner->keys[j];
+            }
+            for (int j = middle + 1; j <= inner->count; j++) {
+                right->children[j - middle - 1] = inner->children[j];
+            }
+            right->count = inner->count - middle - 1;
+            inner->count = middle;
+            return right;
+        }
+
+        /**
+         * @brief Remove k from the subtree rooted at n, refilling any child left below MIN_KEYS
+         * @throw std::runtime_error if the key does not exist in the tree.
+         */
+        void remove(Node* n, const KeyType & k) {
+            if (n->leaf) {
+                Leaf* leaf = asLeaf(n);
+                int i = lowerBound(leaf, k);
+                if (i == leaf->count || k < leaf->keys[i]) {
+                    throw std::runtime_error("Error: Key not found");  // Error if key does not exist
+                }
+                for (int j = i; j + 1 < leaf->count; j++) {
+                    leaf->keys[j] = leaf->keys[j + 1];
+                    leaf->values[j] = std::move(leaf->values[j + 1]);
+                }
+                leaf->count--;
+                leaf->values[leaf->count] = SuccessorList<ValueType>(); // Release the moved-from list
+                keyCount--;
+                return;
+            }
+            Inner* inner = asInner(n);
+            int i = childIndex(inner, k);
+            remove(inner->children[i], k);
+            if (inner->children[i]->count < MIN_KEYS) {
+                refill(inner, i);
+            }
+        }
+
+        /**
+         * @brief Bring children[i] of parent back to MIN_KEYS: borrow a key from a sibling that can spare one,
+         * otherwise merge it with a sibling
+         */
+        void refill(Inner* parent, int i) {
+            Node* child = parent->children[i];
+            Node* left = (i > 0) ? parent->children[i - 1] : nullptr;
+            Node* right = (i < parent->count) ? parent->children[i + 1] : nullptr;
+
+            if (left != nullptr && left->count > MIN_KEYS) {
+                // Shift child right by one and move the last entry of left in front
+                for (int j = child->count; j > 0; j--) {
+                    child->keys[j] = child->keys[j - 1];
+                }
+                if (child->leaf) {
+                    for (int j = child->count; j > 0; j--) {
+                        asLeaf(child)->values[j] = std::move(asLeaf(child)->values[j - 1]);
+                    }
+                    child->keys[0] = left->keys[left->count - 1];
+                    asLeaf(child)->values[0] = std::move(asLeaf(left)->values[left->count - 1]);
+                    parent->keys[i - 1] = child->keys[0];
+                } else {
+                    for (int j = child->count + 1; j > 0; j--) {
+                        asInner(child)->children[j] = asInner(child)->children[j - 1];
+                    }
+                    child->keys[0] = parent->keys[i - 1];
+                    asInner(child)->children[0] = asInner(left)->children[left->count];
+                    parent->keys[i - 1] = left->keys[left->count - 1];
+                }
+                child->count++;
+                left->count--;
+                return;
+            }
+            if (right != nullptr && right->count > MIN_KEYS) {
+                // Append the first entry of right to child and shift right left by one
+                if (child->leaf) {
+                    child->keys[child->count] = right->keys[0];
+                    asLeaf(child)->values[child->count] = std::move(asLeaf(right)->values[0]);
+                    for (int j = 0; j + 1 < right->count; j++) {
+                        right->keys[j] = right->keys[j + 1];
+                        asLeaf(right)->values[j] = std::move(asLeaf(right)->values[j + 1]);
+                    }
+                    parent->keys[i] = right->keys[0];
+                } else {
+                    child->keys[child->count] = parent->keys[i];
+                    asInner(child)->children[child->count + 1] = asInner(right)->children[0];
+                    parent->keys[i] = right->keys[0];
+                    for (int j = 0; j + 1 < right->count; j++) {
+                        right->keys[j] = right->keys[j + 1];
+                    }
+                    for (int j = 0; j < right->count; j++) {
+                        asInner(right)->children[j] = asInner(right)->children[j + 1];
+                    }
+                }
+                child->count++;
+                right->count--;
+                return;
+            }
+            // Neither sibling can spare a key: merge children[m] and children[m + 1]
+            merge(parent, (left != nullptr) ? i - 1 : i);
+        }
+
+        /**
+         * @brief Move children[m + 1] of parent into children[m] and drop the separator keys[m]
+         */
+        void merge(Inner* parent, int m) {
+            Node* left = parent->children[m];
+            Node* right = parent->children[m + 1];
+            if (left->leaf) {
+                for (int j = 0; j < right->count; j++) {
+                    left->keys[left->count + j] = right->keys[j];
+                    asLeaf(left)->values[left->count + j] = std::move(asLeaf(right)->values[j]);
+                }
+                left->count += right->count;
+                asLeaf(left)->next = asLeaf(right)->next;
+                delete asLeaf(right);
+            } else {
+                left->keys[left->count] = parent->keys[m]; // The separator comes down between the two halves
+                for (int j = 0; j < right->count; j++) {
+                    left->keys[left->count + 1 + j] = right->keys[j];
+                }
+                for (int j = 0; j <= right->count; j++) {
+                    asInner(left)->children[left->count + 1 + j] = asInner(right)->children[j];
+                }
+                left->count += right->count + 1;
+                delete asInner(right);
+            }
+            for (int j = m; j + 1 < parent->count; j++) {
+                parent->keys[j] = parent->keys[j + 1];
+            }
+            for (int j = m + 1; j < parent->count; j++) {
+                parent->children[j] = parent->children[j + 1];
+            }
+            parent->count--;
+        }
+
+    public:
+        /**
+         * @brief Constructs an empty B+tree.
+         */
+        BPlusTree() : root(nullptr), keyCount(0) {
+            //Change the seed everytime the new BPlusTree Object is created
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+        }
+
+        ~BPlusTree() {
+            clear(root);
+        }
+
+        BPlusTree(const BPlusTree &) = delete;
+        BPlusTree & operator=(const BPlusTree &) = delete;
 
         /**
-         * @brief Constructs an AVL Node.
-         * @param ele The element (key) to store in the node.
-         * @param lt Pointer to the left child node (defaults to nullptr).
-         * @param rt Pointer to the right child node (defaults to nullptr).
-         * @param h Height of the node (defaults to 0).
+         * @brief Function that return number of keys in the tree
          */
-        AvlNode(const KeyType & key, const ValueType & value, AvlNode *lt = nullptr, AvlNode *rt = nullptr, int h = -1)
-                : key(key), left(lt), right(rt), height(h) 
-                { 
-                    value_count.push_back(ValueCount(value, 1)); //Push the value a initalize its count
-                }
-        
-        };
-        
+        int size() const { return keyCount; }
+
         /**
-         * @brief Pointer to the root node of the AVLTree
+         * @brief Function that return True if the tree is empty, and False otherwise
          */
-        AvlNode *root; 
+        bool empty() const { return keyCount == 0; }
 
         /**
-         * @brief Function to properly delete a node from memory
+         * @brief Insert a key-value pair: increment the value's count if the key exists, else add the key
+         * @param KeyType k The key to insert into the tree.
+         * @param ValueType v The value of the key
          */
-        void clear(AvlNode *t){
-            if (t != nullptr){
-                clear(t->left);
-                clear(t->right);
-                delete t;
-                t = nullptr;
+        void insert(const KeyType & k, const ValueType & v) {
+            if (root == nullptr) {
+                root = new Leaf();
+            }
+            KeyType separator;
+            Node* right = insert(root, k, v, separator);
+            if (right != nullptr) {
+                // The root split: the tree grows one level
+                Inner* newRoot = new Inner();
+                newRoot->keys[0] = separator;
+                newRoot->children[0] = root;
+                newRoot->children[1] = right;
+                newRoot->count = 1;
+                root = newRoot;
             }
         }
+
         /**
-         * @brief Private function to return height of a node
-         * @param AvlNode * t
-         * @return int height, -1 if t is nullptr
+         * @brief Remove an element from the tree
+         * @param KeyType k
          */
-        int height(AvlNode *t) const {
-            if (t == nullptr) {
-                return -1;
-            }
-            else {
-                return t->height;
+        void remove(const KeyType & k) {
+            try {
+                if (root == nullptr) {
+                    throw std::runtime_error("Error: Key not found");
+                }
+                remove(root, k);
+                if (!root->leaf && root->count == 0) {
+                    // The root's last two children merged: the tree shrinks one level
+                    Node* oldRoot = root;
+                    root = asInner(root)->children[0];
+                    delete asInner(oldRoot);
+                } else if (root->leaf && root->count == 0) {
+                    delete asLeaf(root);
+                    root = nullptr;
+                }
+                std::cout << "Remove successful" << std::endl;  // Print success message if no error occurs
+            } catch (const std::runtime_error &e) {
+                std::cerr << "Error: " << e.what() << std::endl;  // Handle error if key not found
             }
         }
+
         /**
-         * @brief Private function to return the size of the tree (number of node) recursively
-         * Function is marked as const to ensure no modification is performed in the Tree structure
-         * @param AvlNode * t
-         * @return int size
+         * @brief Public method to find an element with a given key and print it's value_count.
+         * @param Keytype k
          */
-        int size(AvlNode *t) const {
-            if (t == nullptr) {
-                return 0;
+        void find(const KeyType & k) const {
+            const SuccessorList<ValueType>* values = findValues(k);
+            if (values == nullptr) {
+                std::cout << "No element found" << std::endl;
             }
             else {
-                return (size(t->left) + size(t->right) +  1);
+                for (const auto & vc : *values) {
+                    std::cout << "[Value: " << vc.value << ", Count: " << vc.count << "] " << std::endl;
+                }
             }
+            std::cout << std::endl;
         }
 
         /**
-         * @brief Private function to check if the avl tree rooted at node t
-         * Function is marked as const to ensure no modification is performed on the tree structure
-         * @param AvlNode t
-         * @return True if empty, False if not empty
+         * @brief Public method to get a random value weighted by the count
+         * @param Keytype & k
+         * @return ValueType value
          */
-        bool empty(AvlNode * t) const{
-            if (t == nullptr){
-                return true;
+        ValueType getRandVal(const KeyType & k) {
+            SuccessorList<ValueType>* values = findValues(k);
+            if (values == nullptr) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
             }
-            else return false;
+            return values->sample(rand_num_gen, sampler); // Weighted by the count of each value
         }
-        static const int ALLOWED_IMBALANCE = 1;
+
         /**
-         * @brief Balances the subtree rooted at the given node.
-         * 
-         * This function checks the balance factor of the node and applies the appropriate rotations (single or double)
-         * to ensure that the subtree rooted at the given node is height-balanced.
-         *
-         * @param t Reference to the pointer to the root of the subtree to be balanced.
+         * @brief Choose how getRandVal picks a weighted value (call before finalize())
          */
-        void balance(AvlNode * & t){
-            if (t == nullptr){
-                return;
-            }
-            else if ((height(t->left) - height(t->right)) > ALLOWED_IMBALANCE){
-                if(height(t->left->left) >= height(t->left->right)){
-                    singleWithLeftChild(t);
-                }
-                else doubleWithLeftChild(t);
-            }
-            else if ((height(t->right) - height(t->left)) > ALLOWED_IMBALANCE){
-                if(height(t->right->right) >= height(t->right->left)){
-                    singleWithRightChild(t);
+        void setSampler(SamplerKind kind) {
+            sampler = kind;
+        }
+
+        /**
+         * @brief Build the sampling structure (alias table or prefix sums) of every key once the tree is complete.
+         * Keys inserted into afterwards are rebuilt lazily by their next getRandVal().
+         */
+        void finalize() {
+            for (Leaf* leaf = leftmostLeaf(); leaf != nullptr; leaf = leaf->next) {
+                for (int i = 0; i < leaf->count; i++) {
+                    leaf->values[i].finalize(sampler);
                 }
-                else doubleWithRightChild(t);
             }
-
-            t->height = std::max(height(t->left), height(t->right)) + 1; //Update the height
-
         }
 
         /**
-         * @brief Performs a single rotation for a root node with the left child that has a left-heavy subtree.
-         * Update the height
-         * Update root node
-         * @param k Reference to the pointer to the root of the subtree to rotate.
+         * @brief Call visit(key, successors) for every key of the tree, in key order (along the leaf chain)
          */
-        void singleWithLeftChild(AvlNode* & k){
-            AvlNode * temp = k->left; //create a temp left child of k 
-            k->left = temp->right; //move right child of temp to k left
-            temp->right = k; //make k as temp right child
-            k->height  = std::max(height(k->left), height(k->right)) + 1; //update the height
-            temp->height = std::max(height(temp->left), height(k->right)) + 1; //update the height
-            k = temp; //update root node of the subtree
+        template <typename Visitor>
+        void forEach(Visitor visit) const {
+            for (Leaf* leaf = leftmostLeaf(); leaf != nullptr; leaf = leaf->next) {
+                for (int i = 0; i < leaf->count; i++) {
+                    visit(leaf->keys[i], leaf->values[i]);
+                }
+            }
         }
+
         /**
-         * @brief Performs a single rotation for a root node with the right child that has right-heavy subtree.
-         * Update the height
-         * Update root node
-         * @param k Reference to the pointer to the root of the subtree to rotate.
+         * @brief Copy the keys and successors into a read-only FrozenModel (the tree is unchanged)
          */
-        void singleWithRightChild(AvlNode* & k){
-            AvlNode * temp = k->right; //create a temp left child of k 
-            k->right = temp->left; //move right child of temp to k left
-            temp->left = k; //make k as temp right child
-            k->height  = std::max(height(k->left), height(k->right)) + 1; //update the height
-            temp->height = std::max(height(temp->left), height(k->right)) + 1; //update the height
-            k = temp; //update root node of the subtree
+        FrozenModel<KeyType, ValueType> freeze() const {
+            return FrozenModel<KeyType, ValueType>(*this);
         }
 
         /**
-         * @brief Performs a double rotation for a root node with the left child that has right heavy subtree
-         * Update the height
-         * Update root node
-         * @param k Reference to the pointer to the root of the subtree to rotate.
+         * @brief Public method that displays the keys in order with their values and counts.
          */
-        void doubleWithLeftChild(AvlNode* & k){
-            singleWithRightChild(k->left); //First rotation for the left node of k
-            singleWithLeftChild(k); //Second rotation for k itseft
+        void display() const {
+            if (root == nullptr) {
+                std::cout << "The tree is empty" << std::endl;
+                return;
+            }
+            forEach([](const KeyType & key, const SuccessorList<ValueType> & values) {
+                std::cout << "Key: \'" << key << "\' -> ";
+                for (const auto& vc : values) {
+                    std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
+                }
+                std::cout << std::endl;
+            });
+            std::cout << std::endl;
+        }
+};
+
+/**
+ * @brief SA-IS: sort the suffixes of s (values in [0, upper]) by induced sorting from the LMS suffixes,
+ * recursing on the names of the LMS substrings when they are not all distinct.
+ *
+ * Besides the result (n indices) and s, the workspace is one bit per symbol and one array of the m LMS positions
+ * or names (m <= n / 2, about n / 3 on text). The sorted LMS suffixes and their names are kept in the two halves
+ * of the result while it is not needed, as in the original SA-IS, so no n-sized rank array is needed. Each
+ * recursion level works on at most half the symbols of the one above.
+ * @tparam Index A signed integer type that can hold s.size() (int, or std::int64_t for inputs of 2^31 or more)
+ * @tparam Text Any random-access sequence of symbols (bytes at the top level, Index for the recursion)
+ * @param s The text, as symbols in [0, upper]
+ * @param upper The largest symbol value
+ * @return The suffix array of s (shared by SuffixArrayModel and FMIndexModel)
+ */
+template <typename Index, typename Text>
+std::vector<Index> buildSuffixArray(const Text & s, Index upper) {
+    Index n = static_cast<Index>(s.size());
+    if (n == 0) return {};
+    if (n == 1) return {0};
+    if (n == 2) return (s[0] < s[1]) ? std::vector<Index>{0, 1} : std::vector<Index>{1, 0};
+
+    std::vector<Index> sa(n);
+    std::vector<bool> isS(n, false); // S-type: the suffix is smaller than the next one
+    for (Index i = n - 2; i >= 0; i--) {
+        isS[i] = (s[i] == s[i + 1]) ? isS[i + 1] : (s[i] < s[i + 1]);
+    }
+    auto isLms = [&](Index i) { return i > 0 && isS[i] && !isS[i - 1]; };
+    // Bucket starts: L-type suffixes fill each character's bucket from sumL, S-type ones from sumS
+    std::vector<Index> sumL(upper + 1, 0), sumS(upper + 1, 0);
+    for (Index i = 0; i < n; i++) {
+        if (!isS[i]) {
+            sumS[s[i]]++;
+        } else {
+            sumL[s[i] + 1]++;
+        }
+    }
+    for (Index c = 0; c <= upper; c++) {
+        sumS[c] += sumL[c];
+        if (c < upper) sumL[c + 1] += sumS[c];
+    }
+
+    // Place the LMS suffixes, then induce the L-type suffixes left to right and the S-type ones right to left
+    auto induce = [&](const std::vector<Index> & lms) {
+        std::fill(sa.begin(), sa.end(), -1);
+        std::vector<Index> bucket(sumS);
+        for (Index d : lms) {
+            sa[bucket[s[d]]++] = d;
+        }
+        bucket = sumL;
+        sa[bucket[s[n - 1]]++] = n - 1;
+        for (Index i = 0; i < n; i++) {
+            Index v = sa[i];
+            if (v >= 1 && !isS[v - 1]) sa[bucket[s[v - 1]]++] = v - 1;
+        }
+        bucket = sumL;
+        for (Index i = n - 1; i >= 0; i--) {
+            Index v = sa[i];
+            if (v >= 1 && isS[v - 1]) sa[--bucket[s[v - 1] + 1]] = v - 1;
+        }
+    };
+
+    std::vector<Index> lms; // LMS positions in text order
+    for (Index i = 1; i < n; i++) {
+        if (isLms(i)) lms.push_back(i);
+    }
+    Index m = static_cast<Index>(lms.size());
+    induce(lms);
+    std::vector<Index>().swap(lms);
+
+    if (m > 0) {
+        // Move the LMS suffixes, now sorted by their LMS substring, to the front of sa
+        Index sorted = 0;
+        for (Index i = 0; i < n; i++) {
+            if (isLms(sa[i])) sa[sorted++] = sa[i];
         }
+        // Name the LMS substrings in sorted order; equal substrings get equal names. LMS positions are never
+        // adjacent, so the name of position p fits at sa[m + p / 2], in the back of sa (m <= n / 2)
+        auto nextLms = [&](Index p) {
+            do {
+                p++;
+            } while (p < n && !isLms(p));
+            return p;
+        };
+        std::fill(sa.begin() + m, sa.end(), -1);
+        Index reducedUpper = 0;
+        sa[m + sa[0] / 2] = 0;
+        Index endL = nextLms(sa[0]); // Where the previous LMS substring ends
+        for (Index i = 1; i < m; i++) {
+            Index l = sa[i - 1], r = sa[i];
+            Index endR = nextLms(r);
+            bool same = (endL - l == endR - r);
+            if (same) {
+                while (l < endL && s[l] == s[r]) {
+                    l++;
+                    r++;
+                }
+                if (l == n || s[l] != s[r]) same = false;
+            }
+            if (!same) reducedUpper++;
+            sa[m + sa[i] / 2] = reducedUpper;
+            endL = endR;
+        }
+        // The names in text order form the reduced string
+        std::vector<Index> reduced;
+        reduced.reserve(m);
+        for (Index i = m; i < n; i++) {
+            if (sa[i] >= 0) reduced.push_back(sa[i]);
+        }
+        // Sort the LMS suffixes through the reduced string, then induce the final order from them
+        std::vector<Index> reducedSa = buildSuffixArray(reduced, reducedUpper);
+        reduced.clear(); // Reused for the LMS positions in text order
+        for (Index i = 1; i < n; i++) {
+            if (isLms(i)) reduced.push_back(i);
+        }
+        for (Index i = 0; i < m; i++) {
+            reducedSa[i] = reduced[reducedSa[i]];
+        }
+        std::vector<Index>().swap(reduced);
+        induce(reducedSa);
+    }
+    return sa;
+}
+
+/**
+ * @class SuffixArrayModel
+ * @brief A model of the corpus that serves every window size from one index.
+ *
+ * The suffix array lists the starting positions of all suffixes of the corpus in sorted order, so the
+ * occurrences of any context are one contiguous interval of it, found by binary search. Picking a uniformly
+ * random occurrence and returning the character after it gives each successor with probability count / total,
+ * the same distribution as the count-based structures. Nothing depends on the window size, so the index is
+ * built once (SA-IS, linear time) and getRandVal works for keys of any length.
+ *
+ * The LCP array (Kasai) holds the length of the common prefix of neighbouring suffixes; it gives the number of
+ * distinct contexts of a window size without enumerating them.
+ *
+ * Both arrays hold 32-bit positions (4 bytes per corpus byte each), so the corpus may be at most INT_MAX bytes;
+ * arithmetic on positions is done in std::size_t.
+ */
+class SuffixArrayModel {
+    private:
+        const char* text; // The corpus (not owned)
+        std::size_t length;
+        std::vector<int> suffixArray; // Starting positions of the suffixes, in sorted order
+        std::vector<int> lcp; // lcp[i]: common prefix length of the suffixes at suffixArray[i - 1] and suffixArray[i] (lcp[0] = 0)
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
 
         /**
-         * @brief Performs a double rotation for a root node with the right child that has left heavy subtree
-         * Update the height
-         * Update root node
-         * @param k Reference to the pointer to the root of the subtree to rotate.
+         * @brief Compare the suffix at position p with key, looking at no more than key.length characters
+         * @return < 0, 0 or > 0 like memcmp (a suffix shorter than a key it prefixes is smaller)
          */
-        void doubleWithRightChild(AvlNode* & k){
-            singleWithLeftChild(k->right); //First rotation for the right node of k
-            singleWithRightChild(k); //Second rotation for k itseft
+        int compareSuffix(std::size_t p, const CorpusKey & key) const {
+            std::size_t available = length - p;
+            int result = std::memcmp(text + p, key.bytes, std::min(available, key.length));
+            if (result == 0 && available < key.length) {
+                return -1;
+            }
+            return result;
         }
 
+    public:
         /**
-        * @brief Recursively inserts a new key and value into the subtree rooted at the given node.
-        *
-        * This function inserts the key and its associated value into the correct position in the subtree while maintaining the
-        * binary search tree property. If the key already exists, it updates the value_count vector by adding or updating the value.
-        * After insertion, the function calls `balance` to ensure that the subtree remains balanced.
-        *
-        * @param KeyType k The key to insert.
-        * @param ValueType v The associated value for the key.
-        * @param AvlNode t Reference to the pointer to the root of the subtree in which to insert the key-value pair.
-        */
-        void insert(const KeyType & k, const ValueType & v, AvlNode* & t) {
-            if (t == nullptr) {
-                // If no node exists, create a new node with the key and value
-                t = new AvlNode(k, v);
-            }
-            else if (k < t->key) {
-                insert(k, v, t->left);  // Insert into the left subtree
+         * @brief Build the suffix array and LCP array of the corpus
+         * @param corpus The mapped input file; it must outlive the model
+         * @throws std::runtime_error if the corpus is longer than 32-bit positions can index
+         */
+        explicit SuffixArrayModel(const MappedCorpus & corpus) : text(corpus.data()), length(corpus.size()) {
+            if (length > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+                std::cerr << "Corpus too large for the suffix array: " << length << " bytes (at most "
+                          << std::numeric_limits<int>::max() << "); use --model=fm-index" << std::endl;
+                throw std::runtime_error("Corpus too large");
             }
-            else if (k > t->key) {
-                insert(k, v, t->right);  // Insert into the right subtree
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+
+            // Sort the corpus bytes in place, as unsigned symbols so the order matches CorpusKey (memcmp)
+            suffixArray = buildSuffixArray(std::span(reinterpret_cast<const unsigned char*>(text), length), 255);
+
+            // Kasai: walk the suffixes in text order; the common prefix shrinks by at most one per step
+            std::vector<int> rank(length);
+            for (std::size_t i = 0; i < length; i++) {
+                rank[suffixArray[i]] = static_cast<int>(i);
             }
-            // If the key already exists, check for the value in value_count
-            else {
-                bool valueExists = false;
-                for (auto & vc : t->value_count) {
-                    if (vc.value == v) {
-                        vc.count++;  // Increment the count if the value exists
-                        valueExists = true;
-                        break;
-                    }
+            lcp.assign(length, 0);
+            std::size_t h = 0;
+            for (std::size_t i = 0; i < length; i++) {
+                if (rank[i] == 0) {
+                    h = 0;
+                    continue;
                 }
-                if (valueExists == false) {
-                    // If the value does not exist, add it to the value_count vector with count 1
-                    t->value_count.push_back(ValueCount(v, 1));
+                std::size_t j = suffixArray[rank[i] - 1];
+                while (i + h < length && j + h < length && text[i + h] == text[j + h]) {
+                    h++;
                 }
+                lcp[rank[i]] = static_cast<int>(h);
+                if (h > 0) h--;
             }
-            balance(t);  // Balance the subtree after insertion (height updated here)
         }
 
         /**
-         * @brief Find the minimum node in a subtree (used for node replacement during deletion)
-        */
-        AvlNode* findMin(AvlNode* t) const {
-            if (t == nullptr) return nullptr;
-            if (t->left == nullptr) return t;
-            return findMin(t->left);
+         * @brief The interval [first, second) of the suffix array whose suffixes start with key
+         */
+        std::pair<std::size_t, std::size_t> interval(const CorpusKey & key) const {
+            auto lower = std::partition_point(suffixArray.begin(), suffixArray.end(), [&](int p) { return compareSuffix(p, key) < 0; });
+            auto upper = std::partition_point(lower, suffixArray.end(), [&](int p) { return compareSuffix(p, key) == 0; });
+            return {static_cast<std::size_t>(lower - suffixArray.begin()), static_cast<std::size_t>(upper - suffixArray.begin())};
         }
 
         /**
-        * @brief Recursively removes a node with the specified key from the subtree rooted at the given node.
-        *
-        * This function removes the node with the given key from the subtree while maintaining the binary search tree property.
-        * If the key exists in the tree, the node is removed, and the subtree is rebalanced if necessary.
-        * If the key does not exist, an error condition occurs.
-        * After removal, the function calls `balance` to ensure that the subtree remains balanced.
-        *
-        * @param KeyType k A reference to the key to remove from the AVL tree.
-        * @param AvlNode* & t A pointer reference to the root of the subtree from which to remove the key.
-        * @throw std::runtime_error if the key does not exist in the tree.
-        */
-        void remove(const KeyType & k, AvlNode * & t){
-            if (t == nullptr) {
-                throw std::runtime_error("Error: Key not found");  // Error if key does not exist
+         * @brief Number of distinct contexts of window_size characters that have a next character
+         * (what an AVLTree built with that window size would hold), counted from the LCP array
+         */
+        std::size_t size(long long window_size) const {
+            std::size_t contexts = 0;
+            int sharedWithPrevious = 0; // Common prefix with the last suffix that had room for a context
+            bool first = true;
+            for (std::size_t i = 0; i < length; i++) {
+                sharedWithPrevious = std::min(sharedWithPrevious, lcp[i]);
+                if (static_cast<std::size_t>(suffixArray[i]) + window_size < length) {
+                    if (first || sharedWithPrevious < window_size) {
+                        contexts++;
+                    }
+                    first = false;
+                    sharedWithPrevious = std::numeric_limits<int>::max();
+                }
             }
+            return contexts;
+        }
 
-            if(k < t->key){
-                remove(k, t->left); //key is in the left subtree
+        /**
+         * @brief Get a random value weighted by the count: the character after a random occurrence of k
+         * @param CorpusKey & k The context, of any length
+         * @return char the next character
+         * @throws std::runtime_error if k never occurs followed by a character
+         */
+        char getRandVal(const CorpusKey & k) {
+            auto [first, last] = interval(k);
+            // At most one occurrence (the one ending the corpus) has no next character
+            std::size_t occurrences = last - first;
+            if (occurrences == 1 && suffixArray[first] + k.length >= length) {
+                occurrences = 0;
             }
-            else if(k > t->key){
-                remove(k, t->right); //key is in the right subtree
+            if (occurrences == 0) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
             }
-            //Key found
-            else {
-                //Node has 2 children
-                if(t->left != nullptr && t->right != nullptr){
-                    AvlNode* minNode = findMin(t->right); //find the minimum node of the right subtree
-                    
-                    t->key = minNode->key; //transfer the key
-                    t->value_count = minNode->value_count; //transfer the array
-                    remove(minNode->key, t->right); //remove the minNode from the right subtree
+            std::uniform_int_distribution<std::size_t> dist(first, last - 1);
+            std::size_t p;
+            do {
+                p = suffixArray[dist(rand_num_gen)];
+            } while (p + k.length >= length);
+            return text[p + k.length];
+        }
+};
+
+/**
+ * @class RankBitVector
+ * @brief A bit vector with rank1 in O(1): a 32-bit count of the ones before every block of 8 words (512 bits),
+ * then popcounts inside the block. The counts add 1/16 to the size of the bits. Block counts start over at every
+ * superblock of 2^32 bits, whose 64-bit counts keep ranks exact for vectors of any length.
+ */
+class RankBitVector {
+    private:
+        static constexpr std::size_t BLOCK_WORDS = 8;
+        static constexpr std::size_t SUPERBLOCK_WORDS = std::size_t(1) << 26; // 2^32 bits, a multiple of BLOCK_WORDS
+        std::vector<std::uint64_t> words;
+        std::vector<std::uint32_t> blockRanks; // Ones before each block, since the start of its superblock
+        std::vector<std::uint64_t> superblockRanks; // Ones before each superblock
+
+    public:
+        explicit RankBitVector(std::size_t n = 0) : words((n + 63) / 64, 0) {}
+
+        void set(std::size_t i) { words[i / 64] |= std::uint64_t(1) << (i % 64); }
+        bool get(std::size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+
+        // Build the block counts once all bits are set
+        void buildRanks() {
+            blockRanks.assign(words.size() / BLOCK_WORDS + 1, 0);
+            superblockRanks.assign(words.size() / SUPERBLOCK_WORDS + 1, 0);
+            std::uint64_t ones = 0;
+            for (std::size_t w = 0; w < words.size(); w++) {
+                if (w % SUPERBLOCK_WORDS == 0) {
+                    superblockRanks[w / SUPERBLOCK_WORDS] = ones;
                 }
-                //Node has one or no child
-                else{
-                    AvlNode* oldNode = t;
-                    //Promote the child (if there is)
-                    if(t->left != nullptr){
-                        t = t->left; //promote left child
-                    }
-                    else{
-                        t = t->right; //promote right child
-                    }
-                    delete oldNode;
+                if (w % BLOCK_WORDS == 0) {
+                    blockRanks[w / BLOCK_WORDS] = static_cast<std::uint32_t>(ones - superblockRanks[w / SUPERBLOCK_WORDS]);
                 }
+                ones += std::popcount(words[w]);
             }
-            //END ALL Checks//
-                balance(t);  //Balance the tree
         }
 
-
-        /**
-         * @brief Private method that traverses the subtree rooted at root to find an element of key k 
-         * Return the element (AvlNode)
-         * Function is marked as const -> ensure no modification
-         * @param KeyType & k: Reference of a key
-         * @return pointer to the AvlNode: element. nullptr if no key found
-         */
-        AvlNode* find(const KeyType & k, AvlNode* root) const {
-            //Check for the key value of the current node
-            if((root->key) == k){
-                return root; //return if key is found
-            }
-            //Search left 
-            else if (k < root->key && root->left != nullptr){
-                return find(k, root->left);
+        // Number of ones in [0, i)
+        std::size_t rank1(std::size_t i) const {
+            std::size_t word = i / 64;
+            std::size_t ones = superblockRanks[word / SUPERBLOCK_WORDS] + blockRanks[word / BLOCK_WORDS];
+            for (std::size_t w = word - word % BLOCK_WORDS; w < word; w++) {
+                ones += std::popcount(words[w]);
             }
-            //Search right
-            else if(k > root->key && root->right != nullptr){
-                return find(k, root->right);
+            if (i % 64 != 0) {
+                ones += std::popcount(words[word] & ((std::uint64_t(1) << (i % 64)) - 1));
             }
-            else return nullptr;
+            return ones;
+        }
+        // Number of zeros in [0, i)
+        std::size_t rank0(std::size_t i) const { return i - rank1(i); }
+
+        std::size_t memoryBytes() const {
+            return words.capacity() * sizeof(std::uint64_t) + blockRanks.capacity() * sizeof(std::uint32_t)
+                 + superblockRanks.capacity() * sizeof(std::uint64_t);
         }
+};
+
+/**
+ * @class WaveletMatrix
+ * @brief A sequence of small symbols stored as one RankBitVector per bit (most significant first).
+ *
+ * At each level the sequence is stably reordered with the 0 bits before the 1 bits, so access(i) and rank(c, i)
+ * follow a position through the levels with one rank per level: O(log sigma) time in n log sigma bits.
+ */
+class WaveletMatrix {
+    private:
+        std::vector<RankBitVector> levels;
+        std::vector<std::size_t> zeros; // Number of 0 bits at each level
+
+    public:
+        WaveletMatrix() = default;
 
         /**
-         * @brief Private method that traverses the subtree rooted at the given node.
-         * Recursively performs an in-order traversal of the tree.
-         * Displays keys, values, and their counts in sorted order (left - root - right).
-         * @param AvlNode root: Pointer to the root of the subtree to display.
+         * @param symbols The sequence; every symbol must be below 2^bits
+         * @param bits Number of levels
          */
-        void display(AvlNode* root) const {
-            if (root != nullptr) {
-                display(root->left);  // Traverse the left subtree
+        WaveletMatrix(std::vector<std::uint8_t> symbols, int bits) : levels(bits), zeros(bits) {
+            std::vector<std::uint8_t> zeroSide, oneSide;
+            for (int level = 0; level < bits; level++) {
+                int shift = bits - 1 - level;
+                levels[level] = RankBitVector(symbols.size());
+                zeroSide.clear();
+                oneSide.clear();
+                for (std::size_t i = 0; i < symbols.size(); i++) {
+                    if ((symbols[i] >> shift) & 1) {
+                        levels[level].set(i);
+                        oneSide.push_back(symbols[i]);
+                    } else {
+                        zeroSide.push_back(symbols[i]);
+                    }
+                }
+                levels[level].buildRanks();
+                zeros[level] = zeroSide.size();
+                symbols.assign(zeroSide.begin(), zeroSide.end());
+                symbols.insert(symbols.end(), oneSide.begin(), oneSide.end());
+            }
+        }
 
-                // Display the key
-                std::cout << "Key: \'" << root->key << "\' -> ";
+        // The symbol at position i
+        std::uint8_t access(std::size_t i) const {
+            std::uint8_t symbol = 0;
+            for (std::size_t level = 0; level < levels.size(); level++) {
+                bool bit = levels[level].get(i);
+                symbol = static_cast<std::uint8_t>((symbol << 1) | bit);
+                i = bit ? zeros[level] + levels[level].rank1(i) : levels[level].rank0(i);
+            }
+            return symbol;
+        }
 
-                // Display all values and their counts for this key
-                for (const auto& vc : root->value_count) {
-                    std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
+        // Number of occurrences of symbol in [0, i)
+        std::size_t rank(std::uint8_t symbol, std::size_t i) const {
+            std::size_t start = 0; // Where the symbol's run starts at the next level
+            for (std::size_t level = 0; level < levels.size(); level++) {
+                if ((symbol >> (levels.size() - 1 - level)) & 1) {
+                    start = zeros[level] + levels[level].rank1(start);
+                    i = zeros[level] + levels[level].rank1(i);
+                } else {
+                    start = levels[level].rank0(start);
+                    i = levels[level].rank0(i);
                 }
-                std::cout << std::endl;
+            }
+            return i - start;
+        }
 
-                display(root->right);  // Traverse the right subtree
+        std::size_t memoryBytes() const {
+            std::size_t bytes = zeros.capacity() * sizeof(std::size_t);
+            for (const auto & level : levels) {
+                bytes += level.memoryBytes();
             }
+            return bytes;
         }
+};
 
-        /**
-         * @brief Private method to seed the random generator
-         * Encapsulate the seeding method to avoid manipulation
-         * The function is marked as const to ensure no modification if perform on the Tree structure
-         */
-        /* void initializeRandomGenerator() const {
-            std::srand(static_cast<unsigned>(std::time(NULL))); // Seed the random number generator globally
-        } */
+/**
+ * @class FMIndexModel
+ * @brief A compressed model of the corpus: an FM-index over the reversed corpus.
+ *
+ * In the reversed corpus, the character after an occurrence of context C is the character before an occurrence
+ * of reverse(C), which is what the BWT stores. Backward search for reverse(C) consumes C from left to right
+ * and leaves the interval of rows whose BWT characters are exactly the successors of C, one per occurrence, so
+ * a uniformly random row gives each successor with probability count / total (as HashTable::getRandVal does).
+ *
+ * Only the BWT (as a wavelet matrix over the remapped alphabet) and the symbol counts are kept: the corpus and
+ * the suffix array are not needed after construction. Like SuffixArrayModel, it serves any window size.
+ */
+class FMIndexModel {
+    private:
+        static constexpr std::uint8_t SENTINEL = 0; // Ends the reversed corpus; smaller than every character
+        std::uint8_t symbolOf[256]; // Character -> symbol (1..sigma in character order), or SENTINEL if absent
+        char charOf[256]; // Symbol -> character
+        std::vector<std::size_t> before; // before[c]: number of symbols smaller than c (the C array)
+        WaveletMatrix bwt;
+        std::size_t rows; // Corpus length plus the sentinel
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
 
-        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
-    
         /**
-         * @brief Function to get a value of a given key randomly. 
-         * Value that has a higher count will has a higher chance of being returned.
-         * 
-         * @param Keytype & k key value
-         * @param AvlNode * root: Pointer to the root Node of the substree
-         * @return ValueType value
+         * @brief Backward search: the interval [first, second) of rows for the context k
          */
-        ValueType getRandVal(const KeyType & k, AvlNode * root) {
-            AvlNode* node = find(k, this->root);
-            if (node == nullptr) {
-                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
-                throw std::runtime_error("Key not found");
-            }
-            int totalWeight = 0;
-            //Calculate total weight
-            for (const auto& vc : node->value_count) {
-                    totalWeight += vc.count;
-            }
-            // Generate a random number between 0 and totalWeight - 1
-            std::uniform_int_distribution<int> dist(0, totalWeight - 1);
-            int randNum = dist(rand_num_gen);
-            // Traverse the array and select the value based on the random number
-            int cumulativeWeight = 0;
-            for (const auto& vc : node->value_count) {
-                cumulativeWeight += vc.count;
-                if (randNum < cumulativeWeight) {
-                    return vc.value; // Pick this value
+        std::pair<std::size_t, std::size_t> interval(const CorpusKey & k) const {
+            std::size_t first = 0, last = rows;
+            for (std::size_t i = 0; i < k.length && first < last; i++) {
+                std::uint8_t symbol = symbolOf[static_cast<unsigned char>(k.bytes[i])];
+                if (symbol == SENTINEL) {
+                    return {0, 0}; // The character never occurs
                 }
+                first = before[symbol] + bwt.rank(symbol, first);
+                last = before[symbol] + bwt.rank(symbol, last);
             }
-            return ValueType(); //Fallback, though we should never reach here
+            return {first, last};
         }
 
+        /**
+         * @brief The BWT of text: the symbol before each suffix, in suffix order. The suffix array is released on
+         * return, before the caller builds the wavelet matrix
+         * @tparam Index int while every row fits in it (4 bytes per row), std::int64_t beyond
+         */
+        template <typename Index>
+        static std::vector<std::uint8_t> burrowsWheeler(const std::vector<std::uint8_t> & text, int sigma) {
+            std::vector<Index> suffixArray = buildSuffixArray(text, static_cast<Index>(sigma));
+            std::vector<std::uint8_t> lastColumn(text.size());
+            for (std::size_t i = 0; i < text.size(); i++) {
+                std::size_t p = suffixArray[i];
+                lastColumn[i] = text[(p == 0) ? text.size() - 1 : p - 1];
+            }
+            return lastColumn;
+        }
 
     public:
         /**
-         * @brief Constructs an empty AVL Tree.
+         * @brief Build the index; the corpus is not referenced afterwards.
+         * Construction peaks at about 10 bytes per corpus byte below 2 GiB (the suffix array and the SA-IS
+         * workspace, in 32-bit indices), and about twice that above, where the indices are 64-bit
+         * @param corpus The mapped input file
          */
-        AVLTree() : root(nullptr){
-            //Change the seed everytime the new AVLTree Object is created
+        explicit FMIndexModel(const MappedCorpus & corpus) : rows(corpus.size() + 1) {
             std::random_device ran_device;
             rand_num_gen.seed(ran_device()); //seed the rng
-        }
 
-        /**
-         * @brief Constructs an empty AVL Tree.
-         */
-        ~AVLTree() {
-            clear(root);
+            // Remap the characters that occur to 1..sigma, keeping their (unsigned) order
+            bool present[256] = {};
+            for (char c : corpus) {
+                present[static_cast<unsigned char>(c)] = true;
+            }
+            int sigma = 0;
+            std::memset(symbolOf, SENTINEL, sizeof(symbolOf));
+            std::memset(charOf, 0, sizeof(charOf));
+            for (int c = 0; c < 256; c++) {
+                if (present[c]) {
+                    symbolOf[c] = static_cast<std::uint8_t>(++sigma);
+                    charOf[sigma] = static_cast<char>(c);
+                }
+            }
+
+            // The reversed corpus followed by the sentinel, one byte per symbol
+            std::vector<std::uint8_t> reversed(rows);
+            for (std::size_t i = 0; i < corpus.size(); i++) {
+                reversed[i] = symbolOf[static_cast<unsigned char>(corpus.data()[corpus.size() - 1 - i])];
+            }
+            reversed[rows - 1] = SENTINEL;
+
+            std::vector<std::uint8_t> lastColumn = (rows <= static_cast<std::size_t>(std::numeric_limits<int>::max()))
+                ? burrowsWheeler<int>(reversed, sigma)
+                : burrowsWheeler<std::int64_t>(reversed, sigma);
+            before.assign(sigma + 2, 0);
+            for (std::size_t i = 0; i < rows; i++) {
+                before[reversed[i] + 1]++;
+            }
+            std::vector<std::uint8_t>().swap(reversed);
+            for (int c = 1; c <= sigma + 1; c++) {
+                before[c] += before[c - 1];
+            }
+            bwt = WaveletMatrix(std::move(lastColumn), std::bit_width(static_cast<unsigned>(sigma)));
         }
 
-        // PUBLIC METHOD //
         /**
-         * @brief Function that return number of keys in the Avl Tree
+         * @brief Number of occurrences of k that are followed by a character
          */
-        int size()const;
+        std::size_t count(const CorpusKey & k) const {
+            auto [first, last] = interval(k);
+            std::size_t occurrences = last - first;
+            // The row of the whole reversed corpus has the sentinel as its BWT character: that occurrence ends the corpus
+            if (occurrences > 0 && bwt.rank(SENTINEL, last) - bwt.rank(SENTINEL, first) > 0) {
+                occurrences--;
+            }
+            return occurrences;
+        }
 
         /**
-         * @brief Function that return True if the tree is empty, and False otherwise
+         * @brief Bytes held by the index
          */
-        bool empty() const;
+        std::size_t memoryBytes() const {
+            return bwt.memoryBytes() + before.capacity() * sizeof(std::size_t) + sizeof(symbolOf) + sizeof(charOf);
+        }
 
         /**
-         * @brief Inserts an element into the AVL Tree.
-         *
-         * This function inserts the element into the AVL Tree, ensuring that the tree remains balanced after insertion.
-         * The element is placed based on binary search tree insertion rules.
-         *
-         * @param KeyType k The key to insert into the tree.
-         * @param ValueType v The value of the key
+         * @brief Get a random value weighted by the count: the BWT character of a random row of the context
+         * @param CorpusKey & k The context, of any length
+         * @return char the next character
+         * @throws std::runtime_error if k never occurs followed by a character
          */
-        void insert(const KeyType & k, const ValueType & v);
+        char getRandVal(const CorpusKey & k) {
+            auto [first, last] = interval(k);
+            if (first >= last || (last - first == 1 && bwt.access(first) == SENTINEL)) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
+            }
+            std::uniform_int_distribution<std::size_t> dist(first, last - 1);
+            std::uint8_t symbol;
+            do {
+                symbol = bwt.access(dist(rand_num_gen));
+            } while (symbol == SENTINEL); // At most one row of the interval holds the sentinel
+            return charOf[symbol];
+        }
+};
 
-        /**
-         * @brief Remove an element from the AVL Tree
-         * 
-         * This function remove the element in the AVL Tree with the given key
-         * 
-         * @param KeyType k
-         */
-        void remove(const KeyType & k);
+// Helper functions to view the characters of a key, whatever its type
+std::string_view keyBytes(const CorpusKey & key) { return std::string_view(key.bytes, key.length); }
+std::string_view keyBytes(const std::string & key) { return key; }
 
-        /**
-         * @brief Public method to find an element with a given key and print it's value_count.
-         * This function is marked as const to ensure no modification is performed on the AvlTree structure
-         * 
-         * @param Keytype k
-         */
-        void find(const KeyType & k) const;
+/**
+ * @class CompiledModel
+ * @brief A built tree compiled into a state machine for generation.
+ *
+ * Each context (key) of the model becomes a state. For every successor value of a state, the constructor stores
+ * the index of the state whose context follows: the context without its first characters, plus the value.
+ * Generation is then sampling plus following that index, instead of building a key and searching the tree from
+ * the root for every character.
+ *
+ * The edges are kept in one flat array: the next states of state s are nextState[firstEdge[s] .. firstEdge[s + 1]),
+ * in the order of the successors of s.
+ *
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename ValueType>
+class CompiledModel {
+    public:
+        static constexpr std::uint32_t NO_STATE = std::numeric_limits<std::uint32_t>::max(); // The context is not in the model
 
-        /**
-         * @brief Public method to get a random value weighted by the count
-         * Function is marked as const to ensure no modification is performed on the Tree Structure
-         * @param Keytype & k
-         * @return ValueType value
-         */
-        ValueType getRandVal(const KeyType & k);
+    private:
+        std::vector<SuccessorList<ValueType>> states; // Successors of each state, with their sampling structure built
+        std::vector<std::uint32_t> firstEdge; // Index of the first edge of each state in nextState, plus one past the end
+        std::vector<std::uint32_t> nextState; // State reached by each successor, or NO_STATE at the end of the corpus
+        std::unordered_map<std::string_view, std::uint32_t> stateOf; // Context characters -> state (views into the tree keys)
+        SamplerKind sampler;
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
 
+    public:
         /**
-         * @brief Public method that displays the AVL Tree in in-order traversal.
-         *
-         * This function prints the elements of the AVL Tree in sorted order by performing an in-order traversal.
+         * @brief Compile a finished model (an AVLTree): states are numbered in key order
+         * The keys of the model must stay alive (and unchanged) as long as this object is used.
+         * @param model The model to compile; it is only read
+         * @param kind How successors are sampled
+         * @throws std::runtime_error if the model has more states or edges than 32-bit indices can hold
          */
-        void display() const;
-};
-
-//***IMPLEMENTATION OF PUBLIC METHOD***//
-// Implementation of public insert(key, value)
-template <typename KeyType, typename ValueType>
-void AVLTree<KeyType, ValueType>::insert(const KeyType & x, const ValueType & v) {
-    insert(x, v, this->root);
-}
+        template <typename Model>
+        CompiledModel(const Model & model, SamplerKind kind) : sampler(kind) {
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
 
-// Implementation of public size()
-template <typename KeyType, typename ValueType>
-int AVLTree<KeyType, ValueType>::size() const {
-    return size(this->root);
-}
+            // States and edges are indexed in 32 bits, with NO_STATE reserved
+            std::size_t stateTotal = 0, edgeTotal = 0;
+            model.forEach([&](const auto &, const SuccessorList<ValueType> & successors) {
+                stateTotal++;
+                edgeTotal += successors.size();
+            });
+            if (stateTotal >= NO_STATE || edgeTotal > std::numeric_limits<std::uint32_t>::max()) {
+                std::cerr << "Model too large to compile: " << stateTotal << " states, " << edgeTotal << " edges" << std::endl;
+                throw std::runtime_error("Model too large to compile");
+            }
 
-// Implementation of public empty()
-template <typename KeyType, typename ValueType>
-bool AVLTree<KeyType, ValueType>::empty() const {
-    return empty(this->root);
-}
+            // Number the contexts
+            std::vector<std::string_view> contexts;
+            model.forEach([&](const auto & key, const SuccessorList<ValueType> & successors) {
+                stateOf.emplace(keyBytes(key), static_cast<std::uint32_t>(states.size()));
+                contexts.push_back(keyBytes(key));
+                states.push_back(successors);
+                states.back().finalize(sampler);
+            });
 
-//Impletementation of public find(key)
-template <typename KeyType, typename ValueType>
-void AVLTree<KeyType, ValueType>::find(const KeyType & k) const {
-    AvlNode* node = find(k, this->root);
-    if (node == nullptr){
-        std::cout << "No element found" << std::endl;
-    }
-    else {
-        for(const auto & vc : node->value_count){
-            std::cout << "[Value: " << vc.value << ", Count: " << vc.count << "] " << std::endl;
+            // Resolve every successor to the state of its next context, once
+            firstEdge.reserve(states.size() + 1);
+            std::string next;
+            for (std::size_t s = 0; s < states.size(); s++) {
+                firstEdge.push_back(static_cast<std::uint32_t>(nextState.size()));
+                for (std::size_t j = 0; j < states[s].size(); j++) {
+                    next.assign(contexts[s]);
+                    next += states[s].valueAt(j);
+                    nextState.push_back(findState(std::string_view(next).substr(next.size() - contexts[s].size())));
+                }
+            }
+            firstEdge.push_back(static_cast<std::uint32_t>(nextState.size()));
         }
-    }
-    std::cout << std::endl;
-}
 
-//Implementation of public remove(key)
-template <typename KeyType, typename ValueType>
-void AVLTree<KeyType, ValueType>::remove(const KeyType & k){
-    try {
-        remove(k, this->root);  // Call private remove method
-        std::cout << "Remove successful" << std::endl;  // Print success message if no error occurs
-    } catch (const std::runtime_error &e) {
-        std::cerr << "Error: " << e.what() << std::endl;  // Handle error if key not found
-    }
-}
+        /**
+         * @brief The state of a context, or NO_STATE if the model does not contain it
+         */
+        std::uint32_t findState(std::string_view context) const {
+            auto found = stateOf.find(context);
+            return (found == stateOf.end()) ? NO_STATE : found->second;
+        }
 
-//Implementation of public getRandVal(key)
-template <typename KeyType, typename ValueType>
-ValueType AVLTree<KeyType, ValueType>::getRandVal(const KeyType & k) {
-    return getRandVal(k,this->root);
-}
+        std::size_t size() const { return states.size(); }
 
-// Implementation of public display()
-template <typename KeyType, typename ValueType>
-void AVLTree<KeyType, ValueType>::display() const {
-    if (this->root == nullptr) {
-        std::cout << "The tree is empty" << std::endl;
-    } else {
-        display(this->root);
-        std::cout << std::endl;
-    }
-}
+        /**
+         * @brief Generate text by walking the state machine from the state of the last <Window-Size> characters
+         * @param outString Holds the start context; generated values are appended to it
+         * @param window_size Number of characters in a context
+         * @param desired_length Number of characters to generate
+         * @throws std::runtime_error if a context on the way is not in the model (outString keeps what was generated)
+         */
+        void generate(std::string & outString, long long window_size, long long desired_length) {
+            std::uint32_t state = findState(std::string_view(outString).substr(outString.size() - window_size));
+            while (outString.length() < static_cast<std::size_t>(desired_length)) {
+                if (state == NO_STATE) {
+                    throw std::runtime_error("Key not found");
+                }
+                std::size_t j = states[state].sampleIndex(rand_num_gen, sampler);
+                outString += states[state].valueAt(j);
+                state = nextState[firstEdge[state] + j];
+            }
+        }
+};
 
 // Helper function to check if input is a valid integer and within the range
 bool isValidInteger(const std::string& input, long long& value) {
@@ -562,8 +2811,103 @@ bool isValidInteger(const std::string& input, long long& value) {
     return true;
 }
 
+/**
+ * @brief Build a tree over every window of text, then look every window up once in a shuffled order
+ * @return Build and lookup times in milliseconds
+ */
+template <typename Tree>
+std::pair<long long, long long> timeTree(const std::string & text, long long window_size, const std::vector<std::size_t> & probes) {
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    auto start = std::chrono::steady_clock::now();
+    Tree tree;
+    for (std::size_t p = 0; p + window_size < text.size(); p++) {
+        tree.insert(CorpusKey(text.data() + p, window_size), text[p + window_size]);
+    }
+    tree.finalize();
+    auto built = std::chrono::steady_clock::now();
+    std::size_t checksum = 0; // Keeps the lookups from being optimized away
+    for (std::size_t p : probes) {
+        checksum += (tree.getRandVal(CorpusKey(text.data() + p, window_size)) != '\0');
+    }
+    auto looked_up = std::chrono::steady_clock::now();
+    if (checksum != probes.size()) {
+        std::cerr << "Lookup mismatch" << std::endl;
+    }
+    return {duration_cast<milliseconds>(built - start).count(), duration_cast<milliseconds>(looked_up - built).count()};
+}
+
+/**
+ * @brief Compare AVLTree and BPlusTree on merchant.txt and on a 16 times larger corpus made of copies of it
+ * whose letters are rotated by a different amount each (so each copy adds new contexts)
+ */
+void benchmarkTrees(const MappedCorpus & corpus, long long window_size) {
+    std::string text(corpus.data(), corpus.size());
+    std::string larger;
+    for (int copy = 0; copy < 16; copy++) {
+        for (char c : text) {
+            larger += (c >= 'a' && c <= 'z') ? static_cast<char>('a' + (c - 'a' + copy) % 26) : c;
+        }
+    }
+    std::mt19937 rand_num_gen(12345);
+    for (const std::string * input : {&text, &larger}) {
+        std::vector<std::size_t> probes(input->size() - window_size);
+        for (std::size_t p = 0; p < probes.size(); p++) {
+            probes[p] = p;
+        }
+        std::shuffle(probes.begin(), probes.end(), rand_num_gen);
+        auto [avlBuild, avlLookup] = timeTree<AVLTree<CorpusKey, char>>(*input, window_size, probes);
+        auto [bBuild, bLookup] = timeTree<BPlusTree<CorpusKey, char>>(*input, window_size, probes);
+        std::cout << "Corpus: " << input->size() << " bytes"
+                  << " | AVLTree build: " << avlBuild << " ms, lookups: " << avlLookup << " ms"
+                  << " | BPlusTree build: " << bBuild << " ms, lookups: " << bLookup << " ms" << std::endl;
+    }
+}
+
+// Helper function to read a "--name=value" command line option, or fallback if it is not given
+std::string getOption(int argc, char* argv[], const std::string & name, const std::string & fallback) {
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, prefix.size(), prefix) == 0) {
+            return arg.substr(prefix.size());
+        }
+    }
+    return fallback;
+}
+
+// Helper function to check if a "--name" command line flag is given
+bool hasFlag(int argc, char* argv[], const std::string & name) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--" + name) {
+            return true;
+        }
+    }
+    return false;
+}
+
 //=====MAIN PROGRAM=====//
-int main(){
+// Options: --sampler=alias|prefix|scan how successors are sampled (default alias),
+// --compile generates from a CompiledModel state machine instead of tree lookups,
+// --freeze generates from a FrozenModel (flat sorted arrays) and releases the tree,
+// --model=btree replaces the AVLTree with a BPlusTree,
+// --model=suffix-array|fm-index replaces the tree with a SuffixArrayModel or an FMIndexModel (any window size),
+// --hugepages backs the tree's node arena with transparent huge pages,
+// --restart continues from a uniformly random context of the AVLTree at a dead end instead of stopping,
+// --bench-tree only times AVLTree against BPlusTree at the given window size
+int main(int argc, char* argv[]){
+    std::string model_kind = getOption(argc, argv, "model", "tree");
+    std::string sampler_kind = getOption(argc, argv, "sampler", "alias");
+    bool suffix_array = (model_kind == "suffix-array");
+    bool fm_index = (model_kind == "fm-index");
+    if ((model_kind != "tree" && model_kind != "btree" && !suffix_array && !fm_index) ||
+        (sampler_kind != "alias" && sampler_kind != "prefix" && sampler_kind != "scan") ||
+        (hasFlag(argc, argv, "compile") && hasFlag(argc, argv, "freeze")) ||
+        ((suffix_array || fm_index) && (hasFlag(argc, argv, "compile") || hasFlag(argc, argv, "freeze"))) ||
+        (hasFlag(argc, argv, "restart") && (model_kind != "tree" || hasFlag(argc, argv, "compile") || hasFlag(argc, argv, "freeze")))) {
+        std::cerr << "Usage: " << argv[0] << " [--model=tree|btree|suffix-array|fm-index] [--sampler=alias|prefix|scan] [--compile | --freeze | --restart] [--hugepages] [--bench-tree]" << std::endl;
+        return 1;
+    }
     std::string window_size_str, desired_length_str;
     long long window_size = 0;
     long long desired_length = 0;
@@ -612,82 +2956,153 @@ int main(){
         std::cerr << "Invalid input: <Window-Size> must be smaller than <Input-File-Length> (merchant.txt length)" << std::endl;
         return 1;
     }
+    file.close(); // The probe stream is only used for the length; the bytes are read through the mapping
     //===========================================================//
 
-    AVLTree<std::string,std::string> stringTree;//Declare the Tree structure
-    
-    char next_char;
-    char peek_char;
-    char* buffer = new char[window_size + 1]; // Create a buffer to hold the window
-    // Pre-fill the buffer with the first 'window_size' characters
-    for (int i = 0; i < window_size; i++) {
-        if (file.get(next_char)) {
-            // Replace newline or tab with a space
-            /* if (next_char == '\n' || next_char == '\t') {
-                next_char = ' ';
-            } */
-            buffer[i] = next_char;
-        } else {
-            break; // If the file has fewer characters than the window size
-        }
+    std::unique_ptr<MappedCorpus> corpus_ptr;
+    try {
+        corpus_ptr = std::make_unique<MappedCorpus>("merchant.txt", infile_length); // Map the corpus read-only, reusing the probed length
+    } catch (const std::runtime_error & e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    const MappedCorpus & corpus = *corpus_ptr;
+
+    if (hasFlag(argc, argv, "bench-tree")) {
+        benchmarkTrees(corpus, window_size);
+        return 0;
     }
-    buffer[window_size] = '\0'; // Null-terminate the buffer to treat it as a C-string
+
+    SamplerKind sampler = (sampler_kind == "scan") ? SCAN_SAMPLER : (sampler_kind == "prefix" ? PREFIX_SAMPLER : ALIAS_SAMPLER);
     //NOTE: Save the first string to use for output later
-    std::string firstString(buffer);
-    // Peek the next character in the file stream without extracting it
-    peek_char = file.peek();
-    //Insert to the Tree
-    stringTree.insert(std::string(buffer),std::string(1,peek_char));
-    
-    // Slide the window through the file, one character at a time
-    while (file.get(next_char)) {
-        // Replace newline or tab with a space
-        /* if (next_char == '\n' || next_char == '\t') {
-            next_char = ' ';
-        } */
-        // Shift the buffer to the left by 1 and append the new character
-        for (int i = 0; i < window_size - 1; i++) {
-            buffer[i] = buffer[i + 1];
+    std::string firstString(corpus.begin(), window_size);
+    //Declare the Tree structure. Keys point into the corpus. It is owned through a pointer so --freeze can release it
+    std::unique_ptr<AVLTree<CorpusKey,char>> stringTree;
+    std::unique_ptr<BPlusTree<CorpusKey,char>> bTree;
+    std::unique_ptr<SuffixArrayModel> suffixModel;
+    std::unique_ptr<FMIndexModel> fmModel;
+
+    // Insert every (window, next character) pair of the corpus into an ordered tree (AVLTree or BPlusTree)
+    auto fillTree = [&](auto & tree) {
+        tree.setSampler(sampler);
+
+        char peek_char;
+        // The window is a moving offset into the corpus: advancing it is O(1) whatever the window size
+        const char* window = corpus.begin();
+        const char* last_window = corpus.end() - window_size; // The final window has no next character to record
+
+        // Slide the window through the corpus, one character at a time
+        for (; window < last_window; window++) {
+            peek_char = window[window_size]; // The next character follows the window directly in the corpus
+            //Insert to the Tree
+            tree.insert(CorpusKey(window, window_size),peek_char);
+        }
+        if (!hasFlag(argc, argv, "freeze")) {
+            tree.finalize(); // Build the alias tables (or prefix sums) for sampling
         }
-        buffer[window_size - 1] = next_char; //get the next char
+    };
 
-        
-        peek_char = file.peek();
-        // Check if peek() has returned EOF
-        if (peek_char == EOF) {
-            break; // Exit the loop if we're at the end of the file
-        }
-        // Output the current window
-        /* std::cout << "Insert Key: \'" << buffer <<"\'" << std::endl;
-        std::cout << "Value: \'" << peek_char <<"\'" << std::endl; */
-        //Insert to the Tree
-        stringTree.insert(std::string(buffer),std::string(1,peek_char));
-    }
-    file.close();
-    delete[] buffer; // Clean up dynamically allocated memory
-    //stringTree.display();
+    if (suffix_array) {
+        try {
+            suffixModel = std::make_unique<SuffixArrayModel>(corpus); // Indexes the corpus once, for any window size
+        } catch (const std::runtime_error &) {
+            return 1; // The corpus is too large; the reason is already printed
+        }
+    } else if (fm_index) {
+        fmModel = std::make_unique<FMIndexModel>(corpus); // Like the suffix array, in about log2(alphabet) bits per character
+    } else if (model_kind == "btree") {
+        bTree = std::make_unique<BPlusTree<CorpusKey,char>>();
+        fillTree(*bTree);
+    } else {
+        stringTree = std::make_unique<AVLTree<CorpusKey,char>>(hasFlag(argc, argv, "hugepages")); // Nodes come from a SlabArena
+        fillTree(*stringTree);
+    }
+    //stringTree->display();
     //===================DONE STORING INPUT=====================//
     /// Work on the output
     std::string outString = firstString; // Create an output string and initialize it with firstString
-    std::string windowString = firstString; // Window of sliding characters
+    outString.reserve(desired_length + 1); // Avoid regrowing the output while generating
+    // The window is the last <Window-Size> characters of outString, tracked by its start offset
+    std::size_t window_start = 0;
     //std::cout << "Initial Output String: " << outString << std::endl;
     // Get initial random value based on the first key
-    std::string key = windowString; // Initialize the key with windowString
+    CorpusKey key(outString.data(), window_size); // Probe key viewing the window in outString
     
 
-    try {
-        std::string toAdd = stringTree.getRandVal(key); // Get random value for key
-        int k = 0;
+    // Generate by looking up every window in the model (a tree, its frozen copy, the suffix array or the FM-index)
+    auto generateFrom = [&](auto & model) {
+        char toAdd = model.getRandVal(key); // Get random value for key
         while (outString.length() < desired_length) {
             outString += toAdd;          // Append the random value to the output string
-            // Update the window by removing the first character and adding the next one
-            windowString.erase(0, 1);// Remove the first character of windowString
-            windowString.append(toAdd);// Append the new string (toAdd) to the end of windowString
-
-            // Update the key with the updated windowString
-            key = windowString;
-            toAdd = stringTree.getRandVal(key); // Get new random value based on updated key
-            k++;
+            // Advance the window past the appended character instead of erasing its first character
+            window_start++;
+
+            // Point the key at the window (nothing is copied)
+            key = CorpusKey(outString.data() + window_start, window_size);
+            toAdd = model.getRandVal(key); // Get new random value based on updated key
+        }
+    };
+
+    // Generate from the AVLTree, restarting at dead ends: a window the tree does not know (the last window of the
+    // corpus has no successor) is replaced by a uniformly random key of the tree, found with select() in O(log n)
+    auto generateWithRestarts = [&](auto & tree) {
+        std::mt19937 restart_gen(std::random_device{}());
+        std::uniform_int_distribution<int> pick(0, tree.size() - 1);
+        char next;
+        while (outString.length() < static_cast<std::size_t>(desired_length)) {
+            key = CorpusKey(outString.data() + window_start, window_size);
+            if (tree.tryGetRandVal(key, next)) { // One search, whether or not the window has a successor
+                outString += next;
+                window_start++; // Every value is one character
+            } else {
+                const CorpusKey & seed = tree.select(pick(restart_gen));
+                outString.append(seed.bytes, seed.length); // The seed becomes the next window
+                window_start = outString.length() - window_size;
+            }
+        }
+        outString.resize(desired_length); // A seed may overshoot the desired length
+    };
+
+    // Generate from an ordered tree, directly or through its compiled or frozen form; false if that form was refused
+    auto serveTree = [&](auto & tree) {
+        if (hasFlag(argc, argv, "compile")) {
+            // Walk the compiled state machine instead of searching the tree for every character
+            std::optional<CompiledModel<char>> machine;
+            try {
+                machine.emplace(*tree, sampler);
+            } catch (const std::runtime_error &) {
+                return false; // The model was too large for 32-bit state indices; the reason is already printed
+            }
+            machine->generate(outString, window_size, desired_length);
+        } else if (hasFlag(argc, argv, "freeze")) {
+            // Search flat sorted arrays instead of the node-per-key tree, which is released
+            std::optional<FrozenModel<CorpusKey,char>> frozenModel;
+            try {
+                frozenModel.emplace(tree->freeze());
+            } catch (const std::runtime_error &) {
+                return false; // The model was too large for the frozen arrays; the reason is already printed
+            }
+            tree.reset();
+            generateFrom(*frozenModel);
+        } else {
+            generateFrom(*tree);
+        }
+        return true;
+    };
+
+    try {
+        if (suffixModel) {
+            generateFrom(*suffixModel);
+        } else if (fmModel) {
+            generateFrom(*fmModel);
+        } else if (bTree) {
+            if (!serveTree(bTree)) {
+                return 1;
+            }
+        } else if (hasFlag(argc, argv, "restart")) {
+            generateWithRestarts(*stringTree);
+        } else if (!serveTree(stringTree)) {
+            return 1;
         }
     } catch (const std::runtime_error & e) {
         std::cout << "Caught runtime_error: " << e.what() << std::endl;
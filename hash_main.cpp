@@ -9,45 +9,630 @@
 #include <iostream>
 #include <algorithm> 
 #include <vector>
+#include <memory> //for std::unique_ptr
 #include <type_traits> //for hashing different types
 #include <fstream>
 #include <cstring> //for cstring operations
 #include <random>
 #include <ctime>
 #include <stdexcept>  // For std::stoll
-//#include <chrono>  // For measuring time
+#include <chrono>  // For measuring time
+#include <bit> //for std::countr_zero, std::bit_ceil
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <unordered_map> //for CompiledModel state lookup
+#include <iomanip> //for std::setw when printing 128-bit keys
+#include <array>
+#include <utility> //for std::index_sequence
+#include <optional> //for a compiled or frozen model that may be refused
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> //SSE2 control byte matching in SwissHashTable
+#endif
 
+#if defined(_WIN32)
+#define CORPUS_HAS_MMAP 0 //No mmap on Windows: the corpus is read into a buffer instead
+#else
+#include <sys/mman.h> //for mmap, madvise
+#include <fcntl.h> //for open
+#include <unistd.h> //for close
+#define CORPUS_HAS_MMAP 1
+#endif
 
+/**
+ * @class MappedCorpus
+ * @brief Read-only view of the whole input file as one contiguous range of bytes.
+ *
+ * The file is memory-mapped, so ingestion walks a plain `const char*` range instead of doing a `file.get()` and a
+ * `file.peek()` per byte. Where mmap is not available (or mapping fails) the file is read into a buffer once, which
+ * gives the same contiguous view. The mapping is not advised for sequential access: keys, frozen and compiled
+ * models and index probes keep reading it at random after ingestion, so its pages must not be dropped behind the
+ * first pass.
+ * The corpus must outlive every structure that refers to its bytes.
+ */
+class MappedCorpus {
+    private:
+        const char* bytes; // First byte of the corpus
+        std::size_t length; // Number of bytes in the corpus
+        bool mapped; // True if bytes points into an mmap region that has to be unmapped
+        std::vector<char> fallback; // Owns the bytes when the file could not be mapped
+
+        /**
+         * @brief Read the whole file into the fallback buffer
+         * @param path Path of the input file
+         * @throw std::runtime_error if the file can not be read
+         */
+        void readIntoBuffer(const std::string & path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Error opening input file!");
+            }
+            fallback.resize(length);
+            if (length > 0 && !file.read(fallback.data(), static_cast<std::streamsize>(length))) {
+                throw std::runtime_error("Error reading input file!");
+            }
+            bytes = fallback.data();
+        }
+
+    public:
+        /**
+         * @brief Map the file at path
+         * @param path Path of the input file
+         * @param file_length Size of the file in bytes (from the seekg/tellg probe in main)
+         * @throw std::runtime_error if the file can not be opened or read
+         */
+        MappedCorpus(const std::string & path, std::size_t file_length) : bytes(nullptr), length(file_length), mapped(false) {
+#if CORPUS_HAS_MMAP
+            if (length > 0) {
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::runtime_error("Error opening input file!");
+                }
+                void* region = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd); //The mapping stays valid after the descriptor is closed
+                if (region != MAP_FAILED) {
+                    ::madvise(region, length, MADV_WILLNEED); //Start reading the file in ahead of ingestion
+                    bytes = static_cast<const char*>(region);
+                    mapped = true;
+                    return;
+                }
+            }
+#endif
+            readIntoBuffer(path); //No mmap (or it failed): fall back to one buffered read
+        }
+
+        ~MappedCorpus() {
+#if CORPUS_HAS_MMAP
+            if (mapped) {
+                ::munmap(const_cast<char*>(bytes), length);
+            }
+#endif
+        }
+
+        MappedCorpus(const MappedCorpus &) = delete;
+        MappedCorpus & operator=(const MappedCorpus &) = delete;
+
+        const char* data() const { return bytes; }
+        std::size_t size() const { return length; }
+        const char* begin() const { return bytes; }
+        const char* end() const { return bytes + length; }
+};
 
 /**
- * @class HashTable
- * @brief Implements a hash table with linear probing for collision resolution.
+ * @struct CorpusKey
+ * @brief A context key that refers to its bytes instead of owning a copy of them.
  *
- * The HashTable class provides an efficient data structure for storing key-value pairs.
- * The hash table uses a hash function to map keys to an array index, and resolves collisions
- * using linear probing. This ensures that each key is associated with a unique index in the table,
- * and if collisions occur (i.e., multiple keys hash to the same index), the table finds the next
- * available index in a linear sequence.
+ * A CorpusKey is a (position, length) pair: `bytes` points at an offset inside the mapped corpus and `length` is the
+ * window size. Keys stored in a model always point into the corpus, so a model costs the same per context whatever
+ * the window size. Probe keys used for lookups may point anywhere (e.g. into the generated output).
+ * Comparisons and hashes read the referenced bytes directly.
+ */
+struct CorpusKey {
+    const char* bytes; // First byte of the context (an offset into the corpus for stored keys)
+    std::size_t length; // Number of bytes in the context
+
+    CorpusKey() : bytes(nullptr), length(0) {}
+    CorpusKey(const char* b, std::size_t len) : bytes(b), length(len) {}
+
+    /**
+     * @brief Lexicographic byte comparison
+     * @return negative, zero or positive like std::memcmp
+     */
+    int compare(const CorpusKey & other) const {
+        int result = std::memcmp(bytes, other.bytes, std::min(length, other.length));
+        if (result != 0) {
+            return result;
+        }
+        return (length < other.length) ? -1 : (length > other.length ? 1 : 0);
+    }
+
+    bool operator<(const CorpusKey & other) const { return compare(other) < 0; }
+    bool operator>(const CorpusKey & other) const { return compare(other) > 0; }
+    bool operator==(const CorpusKey & other) const {
+        return length == other.length && std::memcmp(bytes, other.bytes, length) == 0;
+    }
+};
+
+// Print the referenced bytes of a CorpusKey
+std::ostream & operator<<(std::ostream & out, const CorpusKey & key) {
+    return out.write(key.bytes, static_cast<std::streamsize>(key.length));
+}
+
+
+
+/**
+ * @class RollingHash
+ * @brief Rabin-Karp style rolling form of the djb2 hash HashTable uses for string keys.
  *
- * The class supports basic operations such as insertion, deletion, lookup, and rehashing.
- * Insertion and lookup operations are performed in average O(1) time, while rehashing occurs
- * when the table's load factor exceeds a certain threshold. Rehashing dynamically resizes the table
- * and redistributes the elements to maintain efficiency.
+ * djb2 over a window s[0..W) equals SEED*33^W + sum(s[i]*33^(W-1-i)) (mod 2^64). The first term is the same for
+ * every window of a given size, so sliding the window one byte to the right only needs the outgoing byte's term
+ * removed, one multiply and the incoming byte added: O(1) per step instead of O(W).
+ * value() always equals HashTable::hashCode() of the current window, so it can be passed to the
+ * precomputed-hash overloads of insert() and getRandVal().
+ */
+class RollingHash {
+    public:
+        static constexpr size_t SEED = 5381; // djb2 starting value
+        static constexpr size_t MULTIPLIER = 33; // djb2 multiplier
+
+    private:
+        size_t hashVal; // djb2 of the current window
+        size_t seedTerm; // SEED * 33^W, the constant part of every window's hash
+        size_t outgoingWeight; // 33^(W-1), the weight of the window's first byte
+
+    public:
+        /**
+         * @brief Hash the first window
+         * @param window First byte of the window
+         * @param window_size Number of bytes in the window
+         */
+        RollingHash(const char* window, size_t window_size) : hashVal(SEED), seedTerm(SEED), outgoingWeight(1) {
+            for (size_t i = 0; i < window_size; i++) {
+                hashVal = hashVal * MULTIPLIER + window[i];
+                seedTerm *= MULTIPLIER;
+                if (i > 0) {
+                    outgoingWeight *= MULTIPLIER;
+                }
+            }
+        }
+
+        /**
+         * @brief Slide the window one byte to the right
+         * @param outgoing The byte leaving the window (its first byte)
+         * @param incoming The byte entering the window (the byte right after it)
+         */
+        void roll(char outgoing, char incoming) {
+            size_t outgoingByte = static_cast<size_t>(outgoing);
+            size_t incomingByte = static_cast<size_t>(incoming);
+            hashVal = (hashVal - seedTerm - outgoingByte * outgoingWeight) * MULTIPLIER + seedTerm + incomingByte;
+        }
+
+        size_t value() const { return hashVal; }
+};
+
+/**
+ * @struct KeyHash
+ * @brief Hash codes for the key types the hash tables support.
  *
- * The class uses a prime number for the table size to help reduce the likelihood of collisions.
+ * Every table engine in this file hashes keys through KeyHash, so a key has the same full hash code
+ * whichever engine stores it, and a RollingHash value can be passed to any of them.
+ */
+struct KeyHash {
+    /**
+     * @brief Hash function for integers using a large prime constant derived from the golden ratio.
+     *
+     * This hash function takes an integer key and returns a hash value. It uses Knuth's multiplicative hashing technique,
+     * where the key is multiplied by a large prime constant (related to the golden ratio).
+     * This method helps to distribute keys uniformly across the hash table, reducing the chances of collisions.
+     *
+     * @param key The integer key to be hashed.
+     * @return The full hash code of the key (each table reduces it to an index).
+     */
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value, size_t>::type
+    code(const T & key) {
+        size_t largePrime = 2654435761;  // Prime constant (derived from golden ratio)
+        return key * largePrime;
+    }
+    /**
+     * @brief Hash function for strings using a polynomial rolling hash algorithm.
+     *
+     * This hash function computes a hash value for a string by treating it as a polynomial, where each character
+     * is assigned a weight based on its position in the string. The characters are processed from left to right,
+     * and each character is multiplied by a prime number base (37), ensuring that different permutations of the string
+     * result in different hash values.
+     *
+     * The constants are shared with RollingHash, so a window hashed incrementally gets the same code.
+     *
+     * @param key The string key to be hashed.
+     * @return The full hash code of the key (each table reduces it to an index).
+    */
+    static size_t code(const std::string & key) {
+        size_t hashVal = RollingHash::SEED;  // A more suitable starting value for djb2 hash
+        size_t prime = RollingHash::MULTIPLIER;  // A smaller prime number often used for hashing strings
+        
+        for (char ch : key) {
+            // Use bitwise left shift to amplify the effect of each character and add the character value
+            hashVal = ((hashVal*prime) + ch); 
+        }
+        
+        //std::cout << "Hashing key: '" << key << "', Hash val: " << hashVal << std::endl;
+        
+        return hashVal;
+    }
+    /**
+     * @brief Hash function for CorpusKey, the same djb2 polynomial as for strings.
+     *
+     * The bytes are read in place from wherever the key points (the corpus for stored keys),
+     * so a CorpusKey and a std::string with the same contents hash to the same code.
+     *
+     * @param key The corpus key to be hashed.
+     * @return The full hash code of the key (each table reduces it to an index).
+     */
+    static size_t code(const CorpusKey & key) {
+        size_t hashVal = RollingHash::SEED;
+        size_t prime = RollingHash::MULTIPLIER;
+        for (std::size_t i = 0; i < key.length; i++) {
+            hashVal = ((hashVal*prime) + key.bytes[i]);
+        }
+        return hashVal;
+    }
+    /**
+     * @brief Hash function for fixed-size keys (FixedWindow), the same djb2 polynomial as for strings.
+     *
+     * W is known at compile time, so the loop is expanded into W multiply-adds with no loop counter.
+     * A window key gets the same code as a CorpusKey or RollingHash over the same bytes.
+     *
+     * @param key The window bytes to be hashed.
+     * @return The full hash code of the key (each table reduces it to an index).
+     */
+    template <std::size_t W>
+    static size_t code(const std::array<char, W> & key) {
+        return [&key]<std::size_t... I>(std::index_sequence<I...>) {
+            size_t hashVal = RollingHash::SEED;
+            ((hashVal = hashVal * RollingHash::MULTIPLIER + key[I]), ...);
+            return hashVal;
+        }(std::make_index_sequence<W>{});
+    }
+#ifdef __SIZEOF_INT128__
+    /**
+     * @brief Hash function for 128-bit keys (windows of 9 to 16 bytes packed by PackedWindow).
+     *
+     * The high half is folded into the low half with one multiply, then hashed like any integer.
+     * (std::is_integral does not hold for __int128 in strict ISO mode, so it needs its own overload.)
+     *
+     * @param key The packed key to be hashed.
+     * @return The full hash code of the key (each table reduces it to an index).
+     */
+    static size_t code(unsigned __int128 key) {
+        std::uint64_t low = static_cast<std::uint64_t>(key);
+        std::uint64_t high = static_cast<std::uint64_t>(key >> 64);
+        return code(low ^ (high * 0x9E3779B97F4A7C15ull));
+    }
+#endif
+};
+
+#ifdef __SIZEOF_INT128__
+// Print a 128-bit packed key in hexadecimal (the standard streams have no __int128 overload)
+std::ostream & operator<<(std::ostream & out, unsigned __int128 key) {
+    std::ios_base::fmtflags flags = out.flags();
+    out << "0x" << std::hex << static_cast<std::uint64_t>(key >> 64) << std::setw(16) << std::setfill('0')
+        << static_cast<std::uint64_t>(key);
+    out.flags(flags);
+    return out << std::setfill(' ');
+}
+#endif
+
+// Print the bytes of a fixed-size window key
+template <std::size_t W>
+std::ostream & operator<<(std::ostream & out, const std::array<char, W> & key) {
+    return out.write(key.data(), static_cast<std::streamsize>(W));
+}
+
+/**
+ * @struct CorpusWindow
+ * @brief Window policy: the window as a CorpusKey viewing its bytes, hashed by a RollingHash.
  *
- * @tparam KeyType The data type of the keys to be stored in the hash table. The type must support hashing and comparison operators.
- * @tparam ValueType The data type of the values associated with each key.
+ * A window policy gives buildModel() and generateText() the key of a sliding window and its full hash code, and
+ * updates both in O(1) when the window moves one byte to the right. This one works for any window size.
  */
-template <typename KeyType, typename ValueType>
-class HashTable{
+struct CorpusWindow {
+    using KeyType = CorpusKey;
+
+    RollingHash rolling;
+    size_t windowSize;
+
+    CorpusWindow(const char* window, size_t window_size) : rolling(window, window_size), windowSize(window_size) {}
+
+    // Slide the window one byte to the right (outgoing is its first byte, incoming the byte after it)
+    void roll(char outgoing, char incoming) { rolling.roll(outgoing, incoming); }
+    // The key of the window starting at window
+    CorpusKey key(const char* window) const { return CorpusKey(window, windowSize); }
+    // The full hash code of the current window
+    size_t hash() const { return rolling.value(); }
+};
+
+/**
+ * @struct PackedWindow
+ * @brief Window policy for windows of up to sizeof(Word) bytes: the window packed into one unsigned integer.
+ *
+ * The first byte of the window is the most significant one, so sliding shifts the incoming byte in at the bottom
+ * and masks the outgoing byte off the top. The key is the integer itself: it is stored in the table without
+ * pointing anywhere, compared in one instruction and hashed by KeyHash's integer overloads.
+ *
+ * @tparam Word std::uint64_t (windows of up to 8 bytes) or unsigned __int128 (up to 16 bytes)
+ */
+template <typename Word>
+struct PackedWindow {
+    using KeyType = Word;
+
+    Word packed; // The bytes of the current window
+    Word mask; // The low window_size bytes set
+
+    PackedWindow(const char* window, size_t window_size) : packed(0),
+        mask(window_size >= sizeof(Word) ? ~Word(0) : (Word(1) << (8 * window_size)) - 1) {
+        for (size_t i = 0; i < window_size; i++) {
+            packed = (packed << 8) | static_cast<unsigned char>(window[i]);
+        }
+    }
+
+    // Slide the window one byte to the right (the outgoing byte is shifted out by the mask)
+    void roll(char, char incoming) { packed = ((packed << 8) | static_cast<unsigned char>(incoming)) & mask; }
+    // The key of the current window (the window's bytes are already packed, so the pointer is not read)
+    Word key(const char*) const { return packed; }
+    // The full hash code of the current window
+    size_t hash() const { return KeyHash::code(packed); }
+};
+
+/**
+ * @struct FixedWindow
+ * @brief Window policy for a window size fixed at compile time: the window copied into a std::array<char, W>.
+ *
+ * The key owns its W bytes, so copying it, comparing it (std::array's operators become a fixed-size memcmp) and
+ * hashing it (KeyHash's std::array overload) all compile to straight-line code for that W. The hash is still
+ * rolled in O(1) per step; it equals KeyHash::code of the key.
+ *
+ * @tparam W The window size
+ */
+template <std::size_t W>
+struct FixedWindow {
+    using KeyType = std::array<char, W>;
+
+    RollingHash rolling;
+
+    FixedWindow(const char* window, size_t) : rolling(window, W) {}
+
+    // Slide the window one byte to the right (outgoing is its first byte, incoming the byte after it)
+    void roll(char outgoing, char incoming) { rolling.roll(outgoing, incoming); }
+    // The key of the window starting at window (a copy of its W bytes)
+    KeyType key(const char* window) const {
+        KeyType bytes;
+        std::memcpy(bytes.data(), window, W);
+        return bytes;
+    }
+    // The full hash code of the current window
+    size_t hash() const { return rolling.value(); }
+};
+
+// How SuccessorList picks a weighted random value
+enum SamplerKind {
+    SCAN_SAMPLER, // Sum the counts, then scan for the cumulative bucket (two linear passes, nothing to build)
+    ALIAS_SAMPLER, // Walker/Vose alias table: O(1) per sample, O(n) to build after the counts change
+    PREFIX_SAMPLER // Cached prefix sums + branchless binary search (SSE2 compare for 16 values or fewer): cheap to rebuild
+};
+
+/**
+ * @class SuccessorSampler
+ * @brief The sampling structures of one successor list, built over its counts.
+ *
+ * The default sampler uses an alias table (Walker/Vose): after it is built, a sample costs one random number and
+ * one or two array reads instead of two passes over the values. The prefix sampler keeps the cumulative counts
+ * instead, which is cheaper to rebuild while the model is still being updated, and finds the bucket with a
+ * branchless binary search. Either structure is built by finalize(), or lazily by the first sample after
+ * invalidate() (the counts changed), so only contexts that changed are rebuilt.
+ *
+ * The counts are not stored here: each call gets the list's entries (anything with a count member) and their total,
+ * so SuccessorList and its compact char form share this code.
+ */
+class SuccessorSampler {
     private:
+        static constexpr size_t SIMD_PREFIX_LIMIT = 16; // Up to this many values, the prefix sampler compares all sums at once
+
         /**
-         * @struct ValueCount
-         * @brief Store all values associated with the key and the count of each value association
+         * @struct AliasSlot
+         * @brief One column of the alias table: keep value i if the draw is below cut, else take value alias
+         */
+        struct AliasSlot {
+            std::uint32_t cut; // Threshold in [0, totalWeight]
+            std::uint32_t alias; // Index of the value that fills the rest of the column
+        };
+
+        std::vector<AliasSlot> aliasTable; // One column per value, valid only if aliasValid
+        std::vector<std::uint32_t> prefixSums; // prefixSums[i] = count of values 0..i, padded to a multiple of 4; valid only if prefixValid
+        bool aliasValid; // False after invalidate() until the alias table is rebuilt
+        bool prefixValid; // False after invalidate() until the prefix sums are rebuilt
+
+        /**
+         * @brief Build the alias table with Vose's method, in integer arithmetic so it is exact.
          *
-         * The ValueCount is used to stored associated values of each AvlNode
-         * Count how many time each value accociate with the AvlNode
+         * Each count is scaled by the number of values n, so an average column holds exactly totalWeight.
+         * Columns below average are topped up from a column above average, which becomes their alias.
+         */
+        template <typename Entry>
+        void buildAlias(const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            aliasTable.assign(n, AliasSlot{totalWeight, 0});
+            std::vector<std::uint64_t> scaled(n);
+            std::vector<std::uint32_t> small, large;
+            for (size_t i = 0; i < n; i++) {
+                scaled[i] = static_cast<std::uint64_t>(entries[i].count) * n;
+                aliasTable[i].alias = static_cast<std::uint32_t>(i);
+                (scaled[i] < totalWeight ? small : large).push_back(static_cast<std::uint32_t>(i));
+            }
+            while (!small.empty() && !large.empty()) {
+                std::uint32_t s = small.back(); small.pop_back();
+                std::uint32_t l = large.back(); large.pop_back();
+                aliasTable[s].cut = static_cast<std::uint32_t>(scaled[s]);
+                aliasTable[s].alias = l;
+                scaled[l] -= totalWeight - scaled[s]; // l gives away what fills up column s
+                (scaled[l] < totalWeight ? small : large).push_back(l);
+            }
+            // Whatever is left is exactly average: those columns keep their own value
+            aliasValid = true;
+        }
+
+        /**
+         * @brief Build the cumulative counts; the padding never compares <= a draw
+         */
+        template <typename Entry>
+        void buildPrefix(const Entry* entries, size_t n) {
+            prefixSums.assign((n + 3) & ~size_t(3), static_cast<std::uint32_t>(std::numeric_limits<std::int32_t>::max()));
+            std::uint32_t running = 0;
+            for (size_t i = 0; i < n; i++) {
+                running += entries[i].count;
+                prefixSums[i] = running;
+            }
+            prefixValid = true;
+        }
+
+        /**
+         * @brief The original sampler: sum the counts, then scan for the cumulative bucket
+         * @return The index of the chosen value
+         */
+        template <typename Generator, typename Entry>
+        size_t sampleScan(Generator & rand_num_gen, const Entry* entries, size_t n) const {
+            int totalWeight = 0;
+            //Calculate total weight
+            for (size_t i = 0; i < n; i++) {
+                    totalWeight += entries[i].count;
+            }
+            // Generate a random number between 0 and totalWeight - 1
+            std::uniform_int_distribution<int> dist(0, totalWeight - 1);
+            int randNum = dist(rand_num_gen);
+            // Traverse the array and select the value based on the random number
+            int cumulativeWeight = 0;
+            for (size_t i = 0; i < n; i++) {
+                cumulativeWeight += entries[i].count;
+                if (randNum < cumulativeWeight) {
+                    return i; // Pick this value
+                }
+            }
+            return 0; //Fallback, though we should never reach here
+        }
+
+        /**
+         * @brief One random number in [0, n * totalWeight) picks both the alias column and the position inside it
+         * @return The index of the chosen value
+         */
+        template <typename Generator, typename Entry>
+        size_t sampleAlias(Generator & rand_num_gen, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            if (!aliasValid) {
+                buildAlias(entries, n, totalWeight); // Rebuilds only if the counts changed since the last build
+            }
+            std::uint64_t range = static_cast<std::uint64_t>(n) * totalWeight;
+            std::uint64_t randNum;
+            if (range <= std::numeric_limits<std::uint32_t>::max()) {
+                // One 32-bit draw is enough (the common case); a 64-bit distribution would draw twice from mt19937
+                std::uniform_int_distribution<std::uint32_t> dist(0, static_cast<std::uint32_t>(range - 1));
+                randNum = dist(rand_num_gen);
+            } else {
+                std::uniform_int_distribution<std::uint64_t> dist(0, range - 1);
+                randNum = dist(rand_num_gen);
+            }
+            size_t column = static_cast<size_t>(randNum / totalWeight);
+            return (randNum % totalWeight < aliasTable[column].cut) ? column : aliasTable[column].alias;
+        }
+
+        /**
+         * @brief Find the first prefix sum greater than the draw: the number of sums <= the draw is its index
+         * @return The index of the chosen value
+         */
+        template <typename Generator, typename Entry>
+        size_t samplePrefix(Generator & rand_num_gen, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            if (!prefixValid) {
+                buildPrefix(entries, n);
+            }
+            std::uniform_int_distribution<std::uint32_t> dist(0, totalWeight - 1);
+            std::uint32_t randNum = dist(rand_num_gen);
+            size_t index = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            if (n <= SIMD_PREFIX_LIMIT) {
+                // Compare the draw against 4 sums at a time (counts stay below 2^31, so signed compares are safe)
+                __m128i draw = _mm_set1_epi32(static_cast<int>(randNum));
+                for (size_t i = 0; i < prefixSums.size(); i += 4) {
+                    __m128i sums = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&prefixSums[i]));
+                    int notAbove = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(sums, draw))) ^ 0xF;
+                    index += std::popcount(static_cast<unsigned>(notAbove));
+                }
+                return index;
+            }
+#endif
+            // Branchless binary search: the answer stays in [index, index + length)
+            const std::uint32_t* sums = prefixSums.data();
+            for (size_t length = n; length > 1; ) {
+                size_t half = length / 2;
+                index = (sums[index + half - 1] <= randNum) ? index + half : index;
+                length -= half;
+            }
+            return index;
+        }
+
+    public:
+        SuccessorSampler() : aliasValid(false), prefixValid(false) {}
+
+        /**
+         * @brief The counts changed: rebuild whichever structure is used next
+         */
+        void invalidate() {
+            aliasValid = false;
+            prefixValid = false;
+        }
+
+        /**
+         * @brief Build the structure the given sampler needs, if the counts changed since it was last built
+         * @param sampler The sampler that will be used
+         * @param entries The list's values with their counts, n of them, adding up to totalWeight
+         */
+        template <typename Entry>
+        void finalize(SamplerKind sampler, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            if (sampler == ALIAS_SAMPLER && !aliasValid) {
+                buildAlias(entries, n, totalWeight);
+            } else if (sampler == PREFIX_SAMPLER && !prefixValid) {
+                buildPrefix(entries, n);
+            }
+        }
+
+        /**
+         * @brief Draw the index of an entry, weighted by its count (there are at least two entries)
+         * @param rand_num_gen The random number generator of the calling table
+         * @param sampler Which sampler to use (see SamplerKind)
+         * @param entries The list's values with their counts, n of them, adding up to totalWeight
+         */
+        template <typename Generator, typename Entry>
+        size_t sampleIndex(Generator & rand_num_gen, SamplerKind sampler, const Entry* entries, size_t n, std::uint32_t totalWeight) {
+            switch (sampler) {
+                case SCAN_SAMPLER: return sampleScan(rand_num_gen, entries, n);
+                case PREFIX_SAMPLER: return samplePrefix(rand_num_gen, entries, n, totalWeight);
+                default: return sampleAlias(rand_num_gen, entries, n, totalWeight);
+            }
+        }
+};
+
+/**
+ * @class SuccessorList
+ * @brief Store all values associated with a key and the count of each value association
+ *
+ * Every table engine in this file keeps one SuccessorList per key, so counting and weighted
+ * sampling behave the same whichever engine stores the model. Weighted draws go through a SuccessorSampler.
+ * Lists of char values (what main() stores) use the compact form below.
+ *
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename ValueType>
+class SuccessorList {
+    public:
+        /**
+         * @struct ValueCount
+         * @brief One value associated with the key and how many times it was associated
          */
         struct ValueCount {
             ValueType value;  // The value associated with the key
@@ -61,397 +646,2115 @@ class HashTable{
             ValueCount(const ValueType & v, int c) : value(v), count(c) {}
         };
 
-        enum EntryType {ACTIVE, EMPTY, DELETED};
+    private:
+        std::vector<ValueCount> value_count; // Vector of values and their counts
+        std::uint32_t totalWeight; // Sum of all counts
+        SuccessorSampler sampling; // Alias table or prefix sums over value_count
+
+    public:
+        SuccessorList() : totalWeight(0) {}
+
         /**
-         * @struct HashEntry
-         * @brief Represents a key with associated values and their counts in the hash table.
-         *
-         * The HashEntry stores a key along with a vector of associated values and their respective counts.
-         * It also includes a flag indicating whether the entry is active or has been logically deleted.
-         * This structure is particularly useful for open addressing collision resolution techniques
-         * such as linear probing, where deleted entries need to be marked and re-used.
+         * @brief Start the list with one value (count 1)
          */
-        struct HashEntry {
-            KeyType key; // The key of the entry.
-            std::vector<ValueCount> value_count; // Vector of values and their counts.
-            EntryType info; // A flag indicating whether the entry is active or logically deleted.
+        explicit SuccessorList(const ValueType & v) : totalWeight(1) {
+            value_count.push_back(ValueCount(v, 1));
+        }
 
-            /**
-             * @brief Default constructor for HashEntry.
-             *
-             * This constructor initializes the entry with an `EMPTY` status, meaning the slot in the hash table is unoccupied.
-             * No key or value is assigned during this initialization. The entry is ready to be filled when the `insert()` method
-             * places a new key-value pair and marks the entry as `ACTIVE`.
-             */
-            HashEntry() : info(EMPTY) {}
-            
-            /**
-             * @brief Constructs a HashEntry.
-             * @param k The key of the entry.
-             * @param v The value associated with the key.
-             * @param entry_type The status of the entry (ACTIVE, EMPTY, or DELETED).
-             */
-            HashEntry(const KeyType & k, const ValueType & v, EntryType entry_type = ACTIVE)
-                : key(k), info(entry_type) {
-                value_count.push_back(ValueCount(v, 1));  // Add the value with count 1
+        /**
+         * @brief Record one more association with v: increment its count, or add it with count 1
+         * @param v The value that followed the key
+         */
+        void add(const ValueType & v) {
+            totalWeight++;
+            sampling.invalidate(); // The distribution changed
+            for (auto & vc : value_count) {
+                if (vc.value == v) {
+                    vc.count++;  // Increment the count if the value exists
+                    return;
+                }
+            }
+            value_count.push_back(ValueCount(v, 1)); // If not just add a new value
+        }
+
+        /**
+         * @brief Build the structure the given sampler needs, if the counts changed since it was last built
+         * @param sampler The sampler that will be used
+         */
+        void finalize(SamplerKind sampler = ALIAS_SAMPLER) {
+            sampling.finalize(sampler, value_count.data(), value_count.size(), totalWeight);
+        }
+
+        /**
+         * @brief Get a value randomly, weighted by its count.
+         * Value that has a higher count will has a higher chance of being returned.
+         * @param rand_num_gen The random number generator of the calling table
+         * @param sampler Which sampler to use (see SamplerKind)
+         * @return ValueType value
+         */
+        template <typename Generator>
+        ValueType sample(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            return value_count[sampleIndex(rand_num_gen, sampler)].value;
+        }
+
+        /**
+         * @brief Like sample(), but return the position of the chosen value (see valueAt())
+         */
+        template <typename Generator>
+        size_t sampleIndex(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            if (value_count.size() == 1) {
+                return 0; // Nothing to choose from
+            }
+            return sampling.sampleIndex(rand_num_gen, sampler, value_count.data(), value_count.size(), totalWeight);
+        }
+
+        const ValueType & valueAt(size_t i) const { return value_count[i].value; }
+        std::size_t size() const { return value_count.size(); }
+        typename std::vector<ValueCount>::const_iterator begin() const { return value_count.begin(); }
+        typename std::vector<ValueCount>::const_iterator end() const { return value_count.end(); }
+};
+
+/**
+ * @class SuccessorList<char>
+ * @brief Compact successor list for byte values: one successor inline, more in a bitmap-indexed block.
+ *
+ * A context with a single successor (the common case at large window sizes) stores it inline and allocates
+ * nothing. From the second distinct successor on, a Spread block holds a 256-bit presence bitmap and the
+ * ValueCounts of the present bytes in byte order, so the index of byte b is the number of present bytes below b
+ * (a popcount of the bitmap): testing membership and finding the insert position are O(1), with no search.
+ * The interface is the same as the general SuccessorList; values are listed in byte order.
+ */
+template <>
+class SuccessorList<char> {
+    public:
+        /**
+         * @struct ValueCount
+         * @brief One value associated with the key and how many times it was associated
+         */
+        struct ValueCount {
+            char value;  // The value associated with the key
+            int count;  // The count of how many times the value is associated with the key
+
+            ValueCount(char v, int c) : value(v), count(c) {}
+        };
+
+    private:
+        /**
+         * @struct Spread
+         * @brief The successors of a context with two or more of them
+         */
+        struct Spread {
+            std::array<std::uint64_t, 4> present{}; // Bit b is set if byte b is a successor
+            std::vector<ValueCount> value_count; // The present bytes in byte order, with their counts
+            SuccessorSampler sampling; // Alias table or prefix sums over value_count
+
+            // Index of byte b in value_count: the number of present bytes below b
+            size_t rank(unsigned char b) const {
+                size_t word = b >> 6;
+                size_t below = std::popcount(present[word] & ((std::uint64_t(1) << (b & 63)) - 1));
+                for (size_t w = 0; w < word; w++) {
+                    below += std::popcount(present[w]);
+                }
+                return below;
+            }
+            bool contains(unsigned char b) const { return (present[b >> 6] >> (b & 63)) & 1; }
+        };
+
+        ValueCount only; // The successor while there is at most one (count 0 while there is none)
+        std::uint32_t totalWeight; // Sum of all counts
+        std::unique_ptr<Spread> spread; // The successors once there are two or more, nullptr before
+
+    public:
+        SuccessorList() : only(0, 0), totalWeight(0) {}
+
+        /**
+         * @brief Start the list with one value (count 1)
+         */
+        explicit SuccessorList(char v) : only(v, 1), totalWeight(1) {}
+
+        SuccessorList(const SuccessorList & other)
+            : only(other.only), totalWeight(other.totalWeight), spread(other.spread ? std::make_unique<Spread>(*other.spread) : nullptr) {}
+        SuccessorList & operator=(const SuccessorList & other) {
+            if (this != &other) {
+                only = other.only;
+                totalWeight = other.totalWeight;
+                spread = other.spread ? std::make_unique<Spread>(*other.spread) : nullptr;
+            }
+            return *this;
+        }
+        SuccessorList(SuccessorList &&) = default;
+        SuccessorList & operator=(SuccessorList &&) = default;
+
+        /**
+         * @brief Record one more association with v: increment its count, or add it with count 1
+         * @param v The value that followed the key
+         */
+        void add(char v) {
+            totalWeight++;
+            if (!spread) {
+                if (only.count == 0 || only.value == v) {
+                    only.value = v;
+                    only.count++;
+                    return;
+                }
+                // A second distinct successor: move the first one into a Spread
+                spread = std::make_unique<Spread>();
+                spread->present[static_cast<unsigned char>(only.value) >> 6] |= std::uint64_t(1) << (static_cast<unsigned char>(only.value) & 63);
+                spread->value_count.push_back(only);
+            }
+            spread->sampling.invalidate(); // The distribution changed
+            unsigned char b = static_cast<unsigned char>(v);
+            size_t index = spread->rank(b);
+            if (spread->contains(b)) {
+                spread->value_count[index].count++;
+            } else {
+                spread->present[b >> 6] |= std::uint64_t(1) << (b & 63);
+                spread->value_count.insert(spread->value_count.begin() + index, ValueCount(v, 1));
+            }
+        }
+
+        /**
+         * @brief Build the structure the given sampler needs, if the counts changed since it was last built
+         * @param sampler The sampler that will be used
+         */
+        void finalize(SamplerKind sampler = ALIAS_SAMPLER) {
+            if (spread) {
+                spread->sampling.finalize(sampler, spread->value_count.data(), spread->value_count.size(), totalWeight);
+            }
+        }
+
+        /**
+         * @brief Get a value randomly, weighted by its count.
+         * @param rand_num_gen The random number generator of the calling table
+         * @param sampler Which sampler to use (see SamplerKind)
+         * @return char value
+         */
+        template <typename Generator>
+        char sample(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            return valueAt(sampleIndex(rand_num_gen, sampler));
+        }
+
+        /**
+         * @brief Like sample(), but return the position of the chosen value (see valueAt())
+         */
+        template <typename Generator>
+        size_t sampleIndex(Generator & rand_num_gen, SamplerKind sampler = ALIAS_SAMPLER) {
+            if (!spread) {
+                return 0; // Nothing to choose from
+            }
+            return spread->sampling.sampleIndex(rand_num_gen, sampler, spread->value_count.data(), spread->value_count.size(), totalWeight);
+        }
+
+        const char & valueAt(size_t i) const { return spread ? spread->value_count[i].value : only.value; }
+        std::size_t size() const { return spread ? spread->value_count.size() : (only.count > 0 ? 1 : 0); }
+        const ValueCount* begin() const { return spread ? spread->value_count.data() : &only; }
+        const ValueCount* end() const { return begin() + size(); }
+};
+
+/**
+ * @struct PrimeSizing
+ * @brief Table sizing policy: prime table sizes, index = hash code modulo the table size.
+ *
+ * This is the original HashTable sizing. A prime size spreads weak hash codes well, but every index costs an
+ * integer division and every growth runs nextPrime() (trial division up to sqrt(n)).
+ */
+struct PrimeSizing {
+    // Helper function to check if a number is prime
+    static bool isPrime(size_t n) {
+        if (n <= 1) return false;
+        if (n <= 3) return true;
+        if (n % 2 == 0 || n % 3 == 0) return false;
+        //Any prime number larger than 3 is either 1 less than a multiple of 6 (i.e., 6k - 1) or 1 more than a multiple of 6 (i.e., 6k + 1).
+        for (size_t i = 5; i * i <= n; i += 6) { //check up to sqrt(n)
+            if (n % i == 0 || n % (i + 2) == 0)
+                return false;
+        }
+        return true;
+    }
+    // Helper function to find the next prime number greater than or equal to n
+    static size_t nextPrime(size_t n) {
+        // If n is less than 1, return the first prime number (2)
+        if (n <= 1) return 2;
+        // If n is even, increment it by 1 to make it odd
+        if (n % 2 == 0) n++;
+        // Continue checking for primes starting from n
+        while (!isPrime(n)) {
+            n += 2; // Increment by 2 to skip even numbers
+        }
+        return n;
+    }
+
+    size_t tableSize;
+
+    explicit PrimeSizing(size_t n = 2) : tableSize(nextPrime(n)) {}
+
+    size_t size() const { return tableSize; }
+    // Reduce a full hash code to an index in [0, tableSize)
+    size_t index(size_t h) const { return h % tableSize; }
+    // The next slot in linear probing order
+    size_t next(size_t i) const { return (i + 1 == tableSize) ? 0 : i + 1; }
+    // The sizing of a table roughly double this one
+    PrimeSizing grown() const { return PrimeSizing(2 * tableSize); }
+};
+
+/**
+ * @struct PowerOfTwoSizing
+ * @brief Table sizing policy: power-of-two table sizes with Fibonacci hashing.
+ *
+ * The hash code is multiplied by 2^64 / golden ratio and the top log2(size) bits are kept as the index, so
+ * every bit of the hash code influences the index without a division; growing just doubles the size.
+ */
+struct PowerOfTwoSizing {
+    static constexpr std::uint64_t FIBONACCI = 11400714819323198485ull; // 2^64 / golden ratio
+    size_t tableSize;
+    int shift; // 64 - log2(tableSize)
+
+    explicit PowerOfTwoSizing(size_t n = 2) : tableSize(std::bit_ceil(std::max<size_t>(n, 2))), shift(64 - std::countr_zero(tableSize)) {}
+
+    size_t size() const { return tableSize; }
+    // Reduce a full hash code to an index in [0, tableSize): multiply and keep the high bits
+    size_t index(size_t h) const { return static_cast<size_t>((static_cast<std::uint64_t>(h) * FIBONACCI) >> shift); }
+    // The next slot in linear probing order
+    size_t next(size_t i) const { return (i + 1) & (tableSize - 1); }
+    // The sizing of a table double this one
+    PowerOfTwoSizing grown() const { return PowerOfTwoSizing(2 * tableSize); }
+};
+
+// The most keys a table engine presizes for: a larger requested size is only an estimate (e.g. a corpus length),
+// so the table starts at this size and grows as keys actually arrive
+constexpr size_t MAX_PRESIZE_KEYS = size_t(1) << 22;
+
+/**
+ * @class FrozenModel
+ * @brief A read-only copy of a finished model, packed into a few flat arrays.
+ *
+ * keys is sorted, so a lookup is a binary search. The successors of keys[i] are values[successorStart[i] ..
+ * successorStart[i + 1]), and cumulativeCounts holds their running count within that range (the last one is the
+ * total). Sampling draws a number below the total and finds the first running count above it with a branchless
+ * binary search, so no per-key allocation or sampling structure remains.
+ *
+ * Lookups by hash code go through keyIndex, a flat linear-probing index (PowerOfTwoSizing) of key positions, so
+ * generation with a RollingHash stays O(1) per character; lookups without a hash code binary-search keys.
+ *
+ * @tparam KeyType The data type of the keys (views such as CorpusKey stay valid only as long as what they view).
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename KeyType, typename ValueType>
+class FrozenModel {
+    private:
+        std::vector<KeyType> keys; // Sorted
+        std::vector<std::uint32_t> successorStart; // Index of the first successor of each key, plus one past the end
+        std::vector<ValueType> values; // The successors of every key, one after the other
+        std::vector<std::uint32_t> cumulativeCounts; // Running count of each successor within its key's range
+        static constexpr std::uint32_t EMPTY_SLOT = std::numeric_limits<std::uint32_t>::max();
+        PowerOfTwoSizing indexSizing; // At least twice the number of keys
+        std::vector<std::uint32_t> keyIndex; // Position in keys of the key hashed to each slot, or EMPTY_SLOT
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
+
+        /**
+         * @brief Draw a successor of keys[key_index], weighted by the count
+         */
+        ValueType sample(std::size_t key_index) {
+            std::size_t index = successorStart[key_index];
+            std::size_t length = successorStart[key_index + 1] - index;
+            if (length == 1) {
+                return values[index]; // Nothing to choose from
+            }
+            const std::uint32_t* sums = cumulativeCounts.data();
+            std::uniform_int_distribution<std::uint32_t> dist(0, sums[index + length - 1] - 1);
+            std::uint32_t randNum = dist(rand_num_gen);
+            // Branchless binary search: the answer stays in [index, index + length)
+            for (; length > 1; ) {
+                std::size_t half = length / 2;
+                index = (sums[index + half - 1] <= randNum) ? index + half : index;
+                length -= half;
+            }
+            return values[index];
+        }
+
+    public:
+        /**
+         * @brief Copy a model (anything with forEach(visit)) into the flat arrays; the model is only read
+         * @throws std::runtime_error if the model has more keys or successors than 32-bit positions can hold
+         */
+        template <typename Model>
+        explicit FrozenModel(const Model & model) {
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+
+            std::vector<std::pair<KeyType, const SuccessorList<ValueType>*>> entries;
+            std::size_t successorTotal = 0;
+            model.forEach([&](const KeyType & key, const SuccessorList<ValueType> & successors) {
+                entries.emplace_back(key, &successors);
+                successorTotal += successors.size();
+            });
+            // Successor and key positions are stored in 32 bits (EMPTY_SLOT marks a free index slot)
+            if (entries.size() >= EMPTY_SLOT || successorTotal > std::numeric_limits<std::uint32_t>::max()) {
+                std::cerr << "Model too large to freeze: " << entries.size() << " keys, " << successorTotal << " successors" << std::endl;
+                throw std::runtime_error("Model too large to freeze");
+            }
+            std::sort(entries.begin(), entries.end(), [](const auto & a, const auto & b) { return a.first < b.first; });
+
+            keys.reserve(entries.size());
+            successorStart.reserve(entries.size() + 1);
+            values.reserve(successorTotal);
+            cumulativeCounts.reserve(successorTotal);
+            for (const auto & [key, successors] : entries) {
+                keys.push_back(key);
+                successorStart.push_back(static_cast<std::uint32_t>(values.size()));
+                std::uint32_t runningCount = 0;
+                for (const auto & vc : *successors) {
+                    runningCount += vc.count;
+                    values.push_back(vc.value);
+                    cumulativeCounts.push_back(runningCount);
+                }
+            }
+            successorStart.push_back(static_cast<std::uint32_t>(values.size()));
+
+            indexSizing = PowerOfTwoSizing(2 * keys.size());
+            keyIndex.assign(indexSizing.size(), EMPTY_SLOT);
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                size_t slot = indexSizing.index(KeyHash::code(keys[i]));
+                while (keyIndex[slot] != EMPTY_SLOT) {
+                    slot = indexSizing.next(slot);
+                }
+                keyIndex[slot] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+        std::size_t size() const { return keys.size(); }
+
+        /**
+         * @brief Bytes held by the arrays (not counting what the keys or values point to)
+         */
+        std::size_t memoryBytes() const {
+            return keys.capacity() * sizeof(KeyType) + successorStart.capacity() * sizeof(std::uint32_t)
+                 + values.capacity() * sizeof(ValueType) + cumulativeCounts.capacity() * sizeof(std::uint32_t)
+                 + keyIndex.capacity() * sizeof(std::uint32_t);
+        }
+
+        /**
+         * @brief Get a random successor of k, weighted by the count
+         * @param Keytype & k
+         * @return ValueType value
+         * @throws std::runtime_error if the key is not found
+         */
+        ValueType getRandVal(const KeyType & k) {
+            auto found = std::lower_bound(keys.begin(), keys.end(), k);
+            if (found == keys.end() || k < *found) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
+            }
+            return sample(found - keys.begin());
+        }
+
+        /**
+         * @brief getRandVal with a precomputed hash code (e.g. from a RollingHash over the window)
+         * @param Keytype & k
+         * @param h The full hash code of k; must equal what KeyHash::code(k) would return
+         * @return ValueType value
+         * @throws std::runtime_error if the key is not found
+         */
+        ValueType getRandVal(const KeyType & k, size_t h) {
+            for (size_t slot = indexSizing.index(h); keyIndex[slot] != EMPTY_SLOT; slot = indexSizing.next(slot)) {
+                if (keys[keyIndex[slot]] == k) {
+                    return sample(keyIndex[slot]);
+                }
+            }
+            std::cerr << "Key not found in getRandVal: '" << k << "'" << std::endl;
+            throw std::runtime_error("Key not found");
+        }
+
+        /**
+         * @brief Display the keys in order and their values with counts
+         */
+        void display() const {
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                std::cout << "Key: \'" << keys[i] << "\'\n";
+                std::uint32_t previous = 0;
+                for (std::uint32_t j = successorStart[i]; j < successorStart[i + 1]; j++) {
+                    std::cout << "[Value: \'" << values[j] << "\', Count: \'" << cumulativeCounts[j] - previous << "\'] ";
+                    previous = cumulativeCounts[j];
+                }
+                std::cout << std::endl;
+                std::cout << std::endl;
+            }
+        }
+};
+
+/**
+ * @class HashTable
+ * @brief Implements a hash table with linear probing for collision resolution.
+ *
+ * The HashTable class provides an efficient data structure for storing key-value pairs.
+ * The hash table uses a hash function to map keys to an array index, and resolves collisions
+ * using linear probing. This ensures that each key is associated with a unique index in the table,
+ * and if collisions occur (i.e., multiple keys hash to the same index), the table finds the next
+ * available index in a linear sequence.
+ *
+ * The class supports basic operations such as insertion, deletion, lookup, and rehashing.
+ * Insertion and lookup operations are performed in average O(1) time, while rehashing occurs
+ * when the table's load factor exceeds a certain threshold. Rehashing dynamically resizes the table
+ * and redistributes the elements to maintain efficiency.
+ *
+ * How hash codes map to indices is a sizing policy: power-of-two sizes with Fibonacci hashing (the default),
+ * or prime sizes with a modulo (the original behavior), kept so the two can be measured against each other.
+ *
+ * @tparam KeyType The data type of the keys to be stored in the hash table. The type must support hashing and comparison operators.
+ * @tparam ValueType The data type of the values associated with each key.
+ * @tparam Sizing PowerOfTwoSizing or PrimeSizing.
+ */
+template <typename KeyType, typename ValueType, typename Sizing = PowerOfTwoSizing>
+class HashTable{
+    private:
+        enum EntryType {ACTIVE, EMPTY, DELETED};
+        /**
+         * @struct HashEntry
+         * @brief Represents a key with associated values and their counts in the hash table.
+         *
+         * The HashEntry stores a key along with a vector of associated values and their respective counts.
+         * It also includes a flag indicating whether the entry is active or has been logically deleted.
+         * This structure is particularly useful for open addressing collision resolution techniques
+         * such as linear probing, where deleted entries need to be marked and re-used.
+         */
+        struct HashEntry {
+            KeyType key; // The key of the entry.
+            SuccessorList<ValueType> value_count; // Values and their counts.
+            EntryType info; // A flag indicating whether the entry is active or logically deleted.
+            size_t hashCode; // Full hash code of the key (before it is reduced to an index), reused by rehash()
+
+            /**
+             * @brief Default constructor for HashEntry.
+             *
+             * This constructor initializes the entry with an `EMPTY` status, meaning the slot in the hash table is unoccupied.
+             * No key or value is assigned during this initialization. The entry is ready to be filled when the `insert()` method
+             * places a new key-value pair and marks the entry as `ACTIVE`.
+             */
+            HashEntry() : key(), info(EMPTY), hashCode(0) {}
+            
+            /**
+             * @brief Constructs a HashEntry.
+             * @param k The key of the entry.
+             * @param v The value associated with the key.
+             * @param h The full hash code of the key.
+             * @param entry_type The status of the entry (ACTIVE, EMPTY, or DELETED).
+             */
+            HashEntry(const KeyType & k, const ValueType & v, size_t h, EntryType entry_type = ACTIVE)
+                : key(k), value_count(v), info(entry_type), hashCode(h) {}  // Add the value with count 1
+        };
+        static constexpr double LOAD_FACTOR = 0.7; //Constant LOAD FACTOR
+        static constexpr size_t MIGRATE_BUCKETS = 8; // Old buckets migrated per insert/remove while rehashing
+        Sizing sizing; // Size of the table and how hash codes map to its indices
+        int currentSize; // Number of keys in table and oldTable together
+        std::vector<HashEntry> table; // The underlying array represents the hash table
+        std::vector<HashEntry> oldTable; // The previous array while an incremental rehash is in progress, empty otherwise
+        Sizing oldSizing; // Sizing of oldTable
+        size_t migrateIndex; // Next oldTable bucket to migrate
+        
+
+        /**
+         * @brief Full hash code of a key (see KeyHash)
+         * @param key The key to be hashed.
+         * @return The full hash code of the key (reduced to an index by indexFor()).
+         */
+        size_t hashCode(const KeyType & key) const {
+            return KeyHash::code(key);
+        }
+
+        /**
+         * @brief Reduce a full hash code to an index in the table
+         * @param h The hash code from hashCode() or from a RollingHash
+         * @return An index in [0, table size)
+         */
+        size_t indexFor(size_t h) const {
+            return sizing.index(h);
+        }
+        /**
+         * @brief Probe one array for a key with linear probing
+         * @param t The array to search (table or oldTable)
+         * @param tSizing The sizing of t
+         * @param k The key to search for.
+         * @param h The full hash code of k.
+         * @return A pointer to the ACTIVE HashEntry holding k, nullptr if not found
+         */
+        static HashEntry* probe(std::vector<HashEntry> & t, const Sizing & tSizing, const KeyType & k, size_t h) {
+            size_t size = tSizing.size();
+            size_t index = tSizing.index(h);
+            // Continue until an EMPTY slot is found, or every slot was visited (migrated buckets are DELETED,
+            // so oldTable may have no EMPTY slot left)
+            for (size_t probes = 0; probes < size && t[index].info != EMPTY; probes++) {
+                if ((t[index].info == ACTIVE) && (t[index].hashCode == h) && (t[index].key == k)) {
+                    return &t[index];
+                }
+                index = tSizing.next(index);
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief True while entries are still being migrated out of oldTable
+         */
+        bool rehashing() const {
+            return !oldTable.empty();
+        }
+
+        /**
+         * @brief Start an incremental rehash when the load factor becomes too high.
+         *
+         * The current array becomes oldTable and a new array of double the old table size (the next prime number
+         * of it with PrimeSizing) takes its place. No entry is moved here: migrateStep() moves a few old buckets on every insert and remove,
+         * and lookups check both arrays until oldTable is empty, so no single operation pays for the whole table.
+         */
+        void rehash() {
+            if (rehashing()) {
+                migrateStep(oldSizing.size()); // A previous migration is still running: finish it first
+            }
+            oldTable = std::move(table);  // Keep the current table alongside the new one
+            oldSizing = sizing;
+            migrateIndex = 0;
+
+            // Increase table size to roughly double the current size
+            sizing = sizing.grown();
+            table = std::vector<HashEntry>(sizing.size());  // All entries start EMPTY
+        }
+
+        /**
+         * @brief Move an ACTIVE entry of oldTable into the new table, with all its values and counts.
+         * The old bucket becomes DELETED so that probe chains through it in oldTable stay intact.
+         * @param entry The oldTable entry to move (its key is never in the new table as well)
+         */
+        void migrateEntry(HashEntry & entry) {
+            size_t index = indexFor(entry.hashCode);
+            while (table[index].info == ACTIVE) {
+                index = sizing.next(index);
+            }
+            table[index] = std::move(entry);
+            entry = HashEntry();
+            entry.info = DELETED;
+        }
+
+        /**
+         * @brief Migrate up to buckets buckets of oldTable into the new table; release oldTable once all are moved
+         * @param buckets The maximum number of old buckets to visit
+         */
+        void migrateStep(size_t buckets) {
+            for (size_t n = 0; n < buckets && migrateIndex < oldSizing.size(); n++, migrateIndex++) {
+                if (oldTable[migrateIndex].info == ACTIVE) {
+                    //std::cout << "Rehashing key: '" << oldTable[migrateIndex].key << "'" << std::endl;
+                    migrateEntry(oldTable[migrateIndex]);
+                }
+            }
+            if (migrateIndex >= oldSizing.size()) {
+                std::vector<HashEntry>().swap(oldTable); // Migration done
+            }
+        }
+
+        /**
+         * @brief Insert a key-value pair into the hash table.
+         * Uses linear probing to resolve collisions.
+         * @param k The key to be inserted.
+         * @param h The full hash code of k.
+         * @param v The value associated with the key.
+         */
+        void privateInsert(const KeyType & k, size_t h, const ValueType & v) {
+            if (rehashing()) {
+                // A key still in oldTable is moved over first, so it only ever lives in one array
+                HashEntry* old = probe(oldTable, oldSizing, k, h);
+                if (old != nullptr) {
+                    migrateEntry(*old);
+                }
+            }
+            size_t index = indexFor(h); // Reduce the hash code to an index
+            size_t firstDeleted = -1; // Track the first `DELETED` slot found during probing
+
+            //Perform linear probing to resolve collisions if the index already taken. table[index] is a HashEntry
+            while(table[index].info != EMPTY){
+                //If the index is already holding the key that is adding 
+                if((table[index].info == ACTIVE) && (table[index].hashCode == h) && (table[index].key == k)){
+                    //Increment the value if the key already has it, otherwise add it
+                    table[index].value_count.add(v);
+                    return;
+                }
+                /**Record the first DELETED slot encountered. Continue searching to make sure we look at the entire table.
+                * If the key is not in the table we can insert at first deleted slot later after the loop is finish
+                */
+                if (table[index].info == DELETED && firstDeleted == -1) {
+                    firstDeleted = index;
+                }
+                //If the index is not holding the same key that is adding -> Probing
+                index = sizing.next(index);
+            }
+                // If a DELETED slot was found during probing, reuse it for the new entry
+                if (firstDeleted != -1) {
+                    index = firstDeleted;
+                }
+
+            
+            //After Checking. ie: found the index -> Add the HashEntry element to the index (new key only)
+            table[index] = HashEntry(k, v, h); //Default constructor will turn it to active
+            currentSize++; //increase the current size
+        }
+
+        /**
+         * @brief Private method to find the index of a key in the hash table.
+         *
+         * This function performs linear probing to find the index of the given key.
+         * During an incremental rehash, keys not migrated yet are looked up in oldTable.
+         *
+         * @param k The key to search for.
+         * @param h The full hash code of k.
+         * @return A pointer to the HashEntry if found and ACTIVE, nullptr otherwise.
+         */
+        HashEntry* privateFind(const KeyType & k, size_t h) {
+            HashEntry* entry = probe(table, sizing, k, h);
+            if (entry == nullptr && rehashing()) {
+                entry = probe(oldTable, oldSizing, k, h);
+            }
+            return entry;
+        }
+        /**
+         * @brief Removes a key and its associated values from the hash table.
+         *
+         * This function searches for the key using `find()`. If the key is found, it marks the entry as `DELETED`
+         * and decrements `currentSize`. If the key is not found, an error condition is raised.
+         *
+         * @param k The key to be removed.
+         * @return True if the key was successfully removed, false if the key was not found.
+         */
+        bool privateRemove(const KeyType & k) {
+            if (rehashing()) {
+                migrateStep(MIGRATE_BUCKETS);
+            }
+            HashEntry * entry = privateFind(k, hashCode(k));
+            if (entry != nullptr) {
+                // Mark the entry as DELETED and adjust currentSize
+                entry->info = DELETED;
+                currentSize--;  // Decrement currentSize since the element is removed
+                return true;
+            } 
+            else {
+                return false;
+            }
+        }
+
+         /**
+         * @brief Function to get a value of a given key randomly. 
+         * Value that has a higher count will has a higher chance of being returned.
+         * 
+         * @param Keytype & k key value
+         * @param h The full hash code of k
+         * @return ValueType value
+         */
+        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
+        SamplerKind sampler = ALIAS_SAMPLER; // How getRandVal picks a weighted value
+        ValueType privateGetRandVal(const KeyType & k, size_t h) {
+            HashEntry* entry = privateFind(k, h);
+            if (entry == nullptr) {
+                std::cerr << "Key not found in privateGetRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
+            }
+            return entry->value_count.sample(rand_num_gen, sampler); // Weighted by the count of each value
+        }
+       
+
+        /**
+         * @brief Private method to display the contents of the hash table.
+         *
+         * This method iterates over the hash table and prints out the keys and associated values along with their counts.
+         * Only `ACTIVE` entries are displayed, while `EMPTY` and `DELETED` slots are skipped.
+         * This method is intended for internal use and should be called by the public `display()` method.
+         */
+        void privateDisplay() const {
+            for(size_t i = 0; i < sizing.size(); i++){
+                if(table[i].info == ACTIVE){
+                    std::cout << "Index: " << i << " | Key: \'" << table[i].key << "\'\n"; 
+                    for (const auto& vc : table[i].value_count) {
+                        std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
+                    }
+                std::cout << std::endl;    
+                std::cout << std::endl;    
+                }
+            }
+            // Keys not migrated yet by an incremental rehash
+            for(size_t i = 0; i < oldTable.size(); i++){
+                if(oldTable[i].info == ACTIVE){
+                    std::cout << "Old Index: " << i << " | Key: \'" << oldTable[i].key << "\'\n"; 
+                    for (const auto& vc : oldTable[i].value_count) {
+                        std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
+                    }
+                std::cout << std::endl;    
+                std::cout << std::endl;    
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Constructs an empty Hash Table with room for about size keys (at most MAX_PRESIZE_KEYS)
+         */
+        explicit HashTable(size_t size = 101) : sizing(std::min(size, MAX_PRESIZE_KEYS)), currentSize(0), table(sizing.size()), migrateIndex(0) {
+            //Change the seed everytime the new HashTable Object is created
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+        }
+
+        /* ~HashTable() {
+            // Clear the table to ensure all entries are properly deallocated
+            table.clear(); 
+        } */
+
+
+        /**
+         * @brief Public insert method that calls the private insert function.
+         * @param k The key to be inserted.
+         * @param v The value associated with the key.
+         */
+        void insert(const KeyType & k, const ValueType & v) {
+            insert(k, hashCode(k), v);
+        }
+
+        /**
+         * @brief Insert with a precomputed hash code (e.g. from a RollingHash over the window).
+         * @param k The key to be inserted.
+         * @param h The full hash code of k; must equal what hashCode(k) would return.
+         * @param v The value associated with the key.
+         */
+        void insert(const KeyType & k, size_t h, const ValueType & v) {
+            // Move a bounded number of old buckets if a rehash is in progress
+            if (rehashing()) {
+                migrateStep(MIGRATE_BUCKETS);
+            }
+            // Start a rehash if the load factor exceeds 0.7
+            if (this->currentSize >= this->LOAD_FACTOR * sizing.size()) {
+                rehash();
+            }
+            privateInsert(k, h, v);
+        }
+        /**
+         * @brief Returns the number of active elements in the hash table.
+         *
+         * @return The number of active elements in the hash table.
+         */
+        int size() const {
+            return this->currentSize;
+        }
+
+        /**
+         * @brief Checks if the hash table is empty.
+         *
+         * This function returns true if the hash table contains no elements, i.e., if the `currentSize`
+         * is zero. It provides a convenient way to check if the hash table is currently empty.
+         *
+         * @return True if the hash table is empty, false otherwise.
+         */
+        bool empty() const {
+            return currentSize == 0;
+        }
+        /**
+         * @brief Public method to find a key in the hash table and print its key and associated values with their counts.
+         *
+         * This method calls the `privateFind()` function. If the key is found and ACTIVE, it prints the key and its associated
+         * values with their counts.
+         *
+         * @param k The key to search for.
+         */
+        void find(const KeyType & k) const {
+            //Const cast the return value of 'privateFind' to remain encapsulation
+            const HashEntry* entry = const_cast<const HashEntry*>(const_cast<HashTable*>(this)->privateFind(k, hashCode(k))); 
+            
+            if (entry != nullptr) {
+                std::cout << "Key: " << entry->key << "\nValues: ";
+                for (const auto& vc : entry->value_count) {
+                    std::cout << "[Value: '" << vc.value << "', Count: " << vc.count << "] ";
+                }
+                std::cout << std::endl;
+            } else {
+                std::cout << "Key '" << k << "' not found." << std::endl;
+            }
+        }
+        /**
+         * @brief Public method to remove a key from the hash table.
+         *
+         * This method calls the `privateRemove()` function. If the key is not found, it throws a `std::runtime_error`.
+         * Otherwise, the key is removed from the hash table.
+         *
+         * @param k The key to be removed.
+         * @throws std::runtime_error if the key is not found.
+         */
+        void remove(const KeyType k) {
+            if (!privateRemove(k)) {
+                throw std::runtime_error("Error: Key not found in the hash table.");
+            }
+        }
+        /**
+         * @brief Choose how getRandVal picks a weighted value (call before finalize())
+         */
+        void setSampler(SamplerKind kind) {
+            sampler = kind;
+        }
+
+        /**
+         * @brief Build the sampling structure (alias table or prefix sums) of every key once the model is complete.
+         * Keys inserted into afterwards are rebuilt lazily by their next getRandVal().
+         */
+        void finalize() {
+            for (auto & entry : table) {
+                if (entry.info == ACTIVE) {
+                    entry.value_count.finalize(sampler);
+                }
+            }
+            for (auto & entry : oldTable) {
+                if (entry.info == ACTIVE) {
+                    entry.value_count.finalize(sampler);
+                }
+            }
+        }
+
+        /**
+         * @brief Call visit(key, successors) for every key, including keys still waiting in the old table
+         */
+        template <typename Visitor>
+        void forEach(Visitor visit) const {
+            for (const auto & entry : table) {
+                if (entry.info == ACTIVE) {
+                    visit(entry.key, entry.value_count);
+                }
+            }
+            for (const auto & entry : oldTable) {
+                if (entry.info == ACTIVE) {
+                    visit(entry.key, entry.value_count);
+                }
+            }
+        }
+
+        /**
+         * @brief Copy the keys and successors into a read-only FrozenModel (the table is unchanged)
+         */
+        FrozenModel<KeyType, ValueType> freeze() const {
+            return FrozenModel<KeyType, ValueType>(*this);
+        }
+
+        /**
+         * @brief Public method to get a random value weighted by the count
+         * Function is marked as const to ensure no modification is performed on the Tree Structure
+         * @param Keytype & k
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k){
+            return privateGetRandVal(k, hashCode(k));
+        }
+
+        /**
+         * @brief getRandVal with a precomputed hash code (e.g. from a RollingHash over the window)
+         * @param Keytype & k
+         * @param h The full hash code of k; must equal what hashCode(k) would return
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k, size_t h){
+            return privateGetRandVal(k, h);
+        }
+
+        /**
+         * @brief Public display method that calls the private display function.
+         */
+        void display() const {
+            privateDisplay();
+        }
+
+};
+
+/**
+ * @class SwissHashTable
+ * @brief Open-addressing hash table with SIMD-matched control bytes (Swiss table layout).
+ *
+ * Next to the slot array the table keeps one control byte per slot: EMPTY, DELETED, or the top 7 bits of the
+ * key's mixed hash code (its fingerprint) for a full slot. Slots are probed in groups of 16; one SSE2 compare
+ * matches the fingerprint against all 16 control bytes of a group at once, so the full key compare only runs on
+ * fingerprint hits and probing never touches slots that can not match. Groups are visited in triangular order,
+ * which covers every group because the number of groups is a power of two.
+ *
+ * The public interface is the same as HashTable, so both engines can be run on the same corpus.
+ *
+ * @tparam KeyType The data type of the keys to be stored in the hash table. The type must be hashable by KeyHash.
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename KeyType, typename ValueType>
+class SwissHashTable {
+    private:
+        static constexpr size_t GROUP_WIDTH = 16; // Slots matched by one SIMD compare
+        static constexpr int8_t CTRL_EMPTY = -128; // 0b10000000: never used
+        static constexpr int8_t CTRL_DELETED = -2; // 0b11111110: removed, keep probing past it
+        static constexpr size_t MIN_CAPACITY = 2 * GROUP_WIDTH;
+
+        /**
+         * @struct Slot
+         * @brief A key with its full hash code and its successor values
+         */
+        struct Slot {
+            KeyType key;
+            size_t hashCode; // Full hash code of the key, reused when the table grows
+            SuccessorList<ValueType> value_count; // Values and their counts
+
+            Slot() : key(), hashCode(0) {}
+            Slot(const KeyType & k, size_t h, const ValueType & v) : key(k), hashCode(h), value_count(v) {}
+        };
+
+        std::vector<int8_t> ctrl; // One control byte per slot
+        std::vector<Slot> slots; // The slots themselves, only read on fingerprint hits
+        size_t capacity; // Number of slots, a power of two and a multiple of GROUP_WIDTH
+        size_t groupMask; // Number of groups - 1
+        int groupShift; // 64 - log2(number of groups), to take the group index from the high bits
+        int currentSize; // Number of full slots
+        int deletedCount; // Number of DELETED control bytes
+        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
+        SamplerKind sampler = ALIAS_SAMPLER; // How getRandVal picks a weighted value
+
+        /**
+         * @brief Spread the key's hash code over all 64 bits (Fibonacci multiplier), since djb2 mixes its low bits poorly
+         */
+        static std::uint64_t mix(size_t h) {
+            return static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+        }
+        // The 7-bit fingerprint stored in the control byte (top 7 bits of the mixed code)
+        static int8_t fingerprint(std::uint64_t mixed) {
+            return static_cast<int8_t>(mixed >> 57);
+        }
+        // The first group probed for the key (the bits just below the fingerprint)
+        size_t firstGroup(std::uint64_t mixed) const {
+            return static_cast<size_t>((mixed << 7) >> groupShift);
+        }
+
+        /**
+         * @brief Compare one control byte against all 16 control bytes of a group
+         * @param group First control byte of the group
+         * @param b The control byte to look for
+         * @return A bit mask with bit i set if control byte i of the group equals b
+         */
+        static std::uint32_t matchByte(const int8_t* group, int8_t b) {
+#if defined(__SSE2__) || defined(_M_X64)
+            __m128i ctrlBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrlBytes, _mm_set1_epi8(b))));
+#else
+            std::uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++) {
+                if (group[i] == b) mask |= (1u << i);
+            }
+            return mask;
+#endif
+        }
+
+        /**
+         * @brief Find the control bytes of a group that are free for a new key (EMPTY or DELETED)
+         * @param group First control byte of the group
+         * @return A bit mask with bit i set if slot i of the group is free
+         */
+        static std::uint32_t matchFree(const int8_t* group) {
+#if defined(__SSE2__) || defined(_M_X64)
+            // EMPTY and DELETED are the only negative values below -1 (fingerprints are 0..127)
+            __m128i ctrlBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrlBytes)));
+#else
+            std::uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++) {
+                if (group[i] < -1) mask |= (1u << i);
+            }
+            return mask;
+#endif
+        }
+
+        /**
+         * @brief Allocate empty control bytes and slots for a given capacity
+         * @param newCapacity A power of two, at least MIN_CAPACITY
+         */
+        void allocate(size_t newCapacity) {
+            capacity = newCapacity;
+            size_t groups = capacity / GROUP_WIDTH;
+            groupMask = groups - 1;
+            groupShift = 64 - std::countr_zero(groups);
+            ctrl.assign(capacity, CTRL_EMPTY);
+            slots.clear();
+            slots.resize(capacity);
+            deletedCount = 0;
+        }
+
+        /**
+         * @brief Private method to find the slot holding a key
+         * @param k The key to search for.
+         * @param h The full hash code of k.
+         * @return A pointer to the Slot if found, nullptr otherwise.
+         */
+        Slot* privateFind(const KeyType & k, size_t h) {
+            std::uint64_t mixed = mix(h);
+            int8_t fp = fingerprint(mixed);
+            size_t group = firstGroup(mixed);
+            for (size_t step = 1; step <= groupMask + 1; step++) {
+                const int8_t* groupCtrl = &ctrl[group * GROUP_WIDTH];
+                // Full key compares only for slots whose fingerprint matches
+                for (std::uint32_t hits = matchByte(groupCtrl, fp); hits != 0; hits &= hits - 1) {
+                    Slot & slot = slots[group * GROUP_WIDTH + std::countr_zero(hits)];
+                    if (slot.hashCode == h && slot.key == k) {
+                        return &slot;
+                    }
+                }
+                // An EMPTY slot ends the probe sequence: the key would have been placed there
+                if (matchByte(groupCtrl, CTRL_EMPTY) != 0) {
+                    return nullptr;
+                }
+                group = (group + step) & groupMask; // Triangular probing over groups
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief Find the first free (EMPTY or DELETED) slot in the probe sequence of a hash code
+         * @param h The full hash code of the key to be placed
+         * @return The index of the slot
+         */
+        size_t findFreeSlot(size_t h) const {
+            size_t group = firstGroup(mix(h));
+            for (size_t step = 1; ; step++) {
+                std::uint32_t free = matchFree(&ctrl[group * GROUP_WIDTH]);
+                if (free != 0) {
+                    return group * GROUP_WIDTH + std::countr_zero(free);
+                }
+                group = (group + step) & groupMask;
+            }
+        }
+
+        /**
+         * @brief Rebuild the table with room for more keys (or just without tombstones).
+         *
+         * The table doubles when it is at least half full with live keys; otherwise most of the load is DELETED
+         * control bytes and the table is rebuilt at the same capacity to clear them.
+         */
+        void rehash() {
+            std::vector<int8_t> oldCtrl = std::move(ctrl);
+            std::vector<Slot> oldSlots = std::move(slots);
+            size_t newCapacity = (static_cast<size_t>(currentSize) * 2 >= capacity) ? capacity * 2 : capacity;
+            allocate(newCapacity);
+            for (size_t i = 0; i < oldCtrl.size(); i++) {
+                if (oldCtrl[i] >= 0) {
+                    size_t index = findFreeSlot(oldSlots[i].hashCode);
+                    ctrl[index] = oldCtrl[i]; // The fingerprint does not depend on the capacity
+                    slots[index] = std::move(oldSlots[i]);
+                }
+            }
+        }
+
+        /**
+         * @brief Insert a key-value pair into the hash table.
+         * @param k The key to be inserted.
+         * @param h The full hash code of k.
+         * @param v The value associated with the key.
+         */
+        void privateInsert(const KeyType & k, size_t h, const ValueType & v) {
+            Slot* slot = privateFind(k, h);
+            if (slot != nullptr) {
+                slot->value_count.add(v); // Existing key: count the value
+                return;
+            }
+            // Keep at most 7/8 of the slots in use (live keys + tombstones)
+            if ((static_cast<size_t>(currentSize + deletedCount) + 1) * 8 > capacity * 7) {
+                rehash();
+            }
+            size_t index = findFreeSlot(h);
+            if (ctrl[index] == CTRL_DELETED) {
+                deletedCount--;
+            }
+            ctrl[index] = fingerprint(mix(h));
+            slots[index] = Slot(k, h, v);
+            currentSize++;
+        }
+
+        /**
+         * @brief Removes a key and its associated values from the hash table.
+         * @param k The key to be removed.
+         * @return True if the key was successfully removed, false if the key was not found.
+         */
+        bool privateRemove(const KeyType & k) {
+            Slot* slot = privateFind(k, hashCode(k));
+            if (slot == nullptr) {
+                return false;
+            }
+            size_t index = static_cast<size_t>(slot - slots.data());
+            ctrl[index] = CTRL_DELETED; // Later probes must continue past this slot
+            slots[index] = Slot(); // Release the key's values
+            currentSize--;
+            deletedCount++;
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Constructs an empty Swiss table with room for about size keys (at most MAX_PRESIZE_KEYS)
+         */
+        explicit SwissHashTable(size_t size = 101) : currentSize(0), deletedCount(0) {
+            size_t wanted = std::max<size_t>(MIN_CAPACITY, std::min(size, MAX_PRESIZE_KEYS) * 8 / 7 + 1);
+            allocate(std::bit_ceil(wanted));
+            //Change the seed everytime the new SwissHashTable Object is created
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+        }
+
+        /**
+         * @brief Full hash code of a key (see KeyHash)
+         */
+        size_t hashCode(const KeyType & key) const {
+            return KeyHash::code(key);
+        }
+
+        /**
+         * @brief Public insert method that calls the private insert function.
+         * @param k The key to be inserted.
+         * @param v The value associated with the key.
+         */
+        void insert(const KeyType & k, const ValueType & v) {
+            privateInsert(k, hashCode(k), v);
+        }
+
+        /**
+         * @brief Insert with a precomputed hash code (e.g. from a RollingHash over the window).
+         * @param k The key to be inserted.
+         * @param h The full hash code of k; must equal what hashCode(k) would return.
+         * @param v The value associated with the key.
+         */
+        void insert(const KeyType & k, size_t h, const ValueType & v) {
+            privateInsert(k, h, v);
+        }
+
+        /**
+         * @brief Returns the number of keys in the hash table.
+         */
+        int size() const {
+            return currentSize;
+        }
+
+        /**
+         * @brief Checks if the hash table is empty.
+         */
+        bool empty() const {
+            return currentSize == 0;
+        }
+
+        /**
+         * @brief Public method to find a key in the hash table and print its key and associated values with their counts.
+         * @param k The key to search for.
+         */
+        void find(const KeyType & k) const {
+            const Slot* slot = const_cast<SwissHashTable*>(this)->privateFind(k, hashCode(k));
+            if (slot != nullptr) {
+                std::cout << "Key: " << slot->key << "\nValues: ";
+                for (const auto& vc : slot->value_count) {
+                    std::cout << "[Value: '" << vc.value << "', Count: " << vc.count << "] ";
+                }
+                std::cout << std::endl;
+            } else {
+                std::cout << "Key '" << k << "' not found." << std::endl;
+            }
+        }
+
+        /**
+         * @brief Public method to remove a key from the hash table.
+         * @param k The key to be removed.
+         * @throws std::runtime_error if the key is not found.
+         */
+        void remove(const KeyType k) {
+            if (!privateRemove(k)) {
+                throw std::runtime_error("Error: Key not found in the hash table.");
+            }
+        }
+
+        /**
+         * @brief Choose how getRandVal picks a weighted value (call before finalize())
+         */
+        void setSampler(SamplerKind kind) {
+            sampler = kind;
+        }
+
+        /**
+         * @brief Build the sampling structure (alias table or prefix sums) of every key once the model is complete.
+         * Keys inserted into afterwards are rebuilt lazily by their next getRandVal().
+         */
+        void finalize() {
+            for (size_t i = 0; i < capacity; i++) {
+                if (ctrl[i] >= 0) {
+                    slots[i].value_count.finalize(sampler);
+                }
+            }
+        }
+
+        /**
+         * @brief Call visit(key, successors) for every key, in slot order
+         */
+        template <typename Visitor>
+        void forEach(Visitor visit) const {
+            for (size_t i = 0; i < capacity; i++) {
+                if (ctrl[i] >= 0) {
+                    visit(slots[i].key, slots[i].value_count);
+                }
+            }
+        }
+
+        /**
+         * @brief Copy the keys and successors into a read-only FrozenModel (the table is unchanged)
+         */
+        FrozenModel<KeyType, ValueType> freeze() const {
+            return FrozenModel<KeyType, ValueType>(*this);
+        }
+
+        /**
+         * @brief Public method to get a random value weighted by the count
+         * @param Keytype & k
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k) {
+            return getRandVal(k, hashCode(k));
+        }
+
+        /**
+         * @brief getRandVal with a precomputed hash code (e.g. from a RollingHash over the window)
+         * @param Keytype & k
+         * @param h The full hash code of k; must equal what hashCode(k) would return
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k, size_t h) {
+            Slot* slot = privateFind(k, h);
+            if (slot == nullptr) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
+                throw std::runtime_error("Key not found");
+            }
+            return slot->value_count.sample(rand_num_gen, sampler);
+        }
+
+        /**
+         * @brief Display the keys and their values with counts, in slot order
+         */
+        void display() const {
+            for (size_t i = 0; i < capacity; i++) {
+                if (ctrl[i] >= 0) {
+                    std::cout << "Index: " << i << " | Key: \'" << slots[i].key << "\'\n";
+                    for (const auto& vc : slots[i].value_count) {
+                        std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
+                    }
+                    std::cout << std::endl;
+                    std::cout << std::endl;
+                }
+            }
+        }
+};
+
+/**
+ * @class RobinHoodHashTable
+ * @brief Linear-probing hash table with Robin Hood displacement and backward-shift deletion.
+ *
+ * Every slot records its probe distance (how far it sits from its home slot). On insert, a key that has probed
+ * further than the resident of a slot takes that slot and the resident moves on ("take from the rich"), which keeps
+ * the variance of probe distances small. A lookup can stop as soon as it meets a resident closer to home than the
+ * distance probed so far. Removal shifts the following cluster back by one slot instead of leaving a tombstone,
+ * so probe chains do not grow on workloads that keep inserting and removing contexts.
+ *
+ * The public interface is the same as HashTable, plus maxProbeDistance() and meanProbeDistance().
+ *
+ * @tparam KeyType The data type of the keys to be stored in the hash table. The type must be hashable by KeyHash.
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename KeyType, typename ValueType>
+class RobinHoodHashTable {
+    private:
+        static constexpr double LOAD_FACTOR = 0.85; // Robin Hood keeps probes short at higher loads than plain linear probing
+        static constexpr size_t MIN_CAPACITY = 16;
+
+        /**
+         * @struct Slot
+         * @brief A key with its full hash code, its successor values and its distance from its home slot
+         */
+        struct Slot {
+            KeyType key;
+            size_t hashCode; // Full hash code of the key, reused when the table grows
+            SuccessorList<ValueType> value_count; // Values and their counts
+            int distance; // Probe distance from the home slot, -1 if the slot is empty
+
+            Slot() : key(), hashCode(0), distance(-1) {}
+            Slot(const KeyType & k, size_t h, const ValueType & v) : key(k), hashCode(h), value_count(v), distance(0) {}
+        };
+
+        std::vector<Slot> slots;
+        size_t capacity; // Number of slots, a power of two
+        int shift; // 64 - log2(capacity), to take the home slot from the high bits of the mixed hash
+        int currentSize;
+        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
+        SamplerKind sampler = ALIAS_SAMPLER; // How getRandVal picks a weighted value
+
+        // Home slot of a hash code: Fibonacci-mix it and keep the high bits
+        size_t home(size_t h) const {
+            return static_cast<size_t>((static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ull) >> shift);
+        }
+        size_t next(size_t index) const {
+            return (index + 1) & (capacity - 1);
+        }
+
+        /**
+         * @brief Allocate an empty slot array
+         * @param newCapacity A power of two, at least 2
+         */
+        void allocate(size_t newCapacity) {
+            capacity = newCapacity;
+            shift = 64 - std::countr_zero(capacity);
+            slots.clear();
+            slots.resize(capacity);
+        }
+
+        /**
+         * @brief Place a slot whose key is not in the table yet, displacing residents that are closer to home
+         * @param incoming The slot to be placed (its distance is reset to 0)
+         */
+        void place(Slot incoming) {
+            size_t index = home(incoming.hashCode);
+            incoming.distance = 0;
+            while (slots[index].distance >= 0) {
+                if (slots[index].distance < incoming.distance) {
+                    std::swap(incoming, slots[index]); // The poorer key takes the slot; the resident keeps probing
+                }
+                index = next(index);
+                incoming.distance++;
+            }
+            slots[index] = std::move(incoming);
+        }
+
+        /**
+         * @brief Double the table and place every key again
+         */
+        void rehash() {
+            std::vector<Slot> oldSlots = std::move(slots);
+            allocate(capacity * 2);
+            for (auto & slot : oldSlots) {
+                if (slot.distance >= 0) {
+                    place(std::move(slot));
+                }
+            }
+        }
+
+        /**
+         * @brief Private method to find the index of the slot holding a key
+         * @param k The key to search for.
+         * @param h The full hash code of k.
+         * @return The index of the slot, or capacity if the key is not in the table.
+         */
+        size_t privateFind(const KeyType & k, size_t h) const {
+            size_t index = home(h);
+            // Stop at an empty slot, or at a resident closer to home than we are: k would have displaced it
+            for (int distance = 0; slots[index].distance >= distance; distance++) {
+                if (slots[index].hashCode == h && slots[index].key == k) {
+                    return index;
+                }
+                index = next(index);
+            }
+            return capacity;
+        }
+
+        /**
+         * @brief Insert a key-value pair into the hash table.
+         * @param k The key to be inserted.
+         * @param h The full hash code of k.
+         * @param v The value associated with the key.
+         */
+        void privateInsert(const KeyType & k, size_t h, const ValueType & v) {
+            size_t index = privateFind(k, h);
+            if (index != capacity) {
+                slots[index].value_count.add(v); // Existing key: count the value
+                return;
+            }
+            if (currentSize + 1 > LOAD_FACTOR * capacity) {
+                rehash();
+            }
+            place(Slot(k, h, v));
+            currentSize++;
+        }
+
+        /**
+         * @brief Removes a key with backward-shift deletion (no tombstones).
+         *
+         * Every following slot of the cluster that is not in its home slot moves back by one, until an empty slot
+         * or a slot at distance 0 is reached.
+         *
+         * @param k The key to be removed.
+         * @return True if the key was successfully removed, false if the key was not found.
+         */
+        bool privateRemove(const KeyType & k) {
+            size_t index = privateFind(k, hashCode(k));
+            if (index == capacity) {
+                return false;
             }
-        };
-        // Helper function to check if a number is prime
-        bool isPrime(int n) {
-            if (n <= 1) return false;
-            if (n <= 3) return true;
-            if (n % 2 == 0 || n % 3 == 0) return false;
-            //Any prime number larger than 3 is either 1 less than a multiple of 6 (i.e., 6k - 1) or 1 more than a multiple of 6 (i.e., 6k + 1).
-            for (int i = 5; i * i <= n; i += 6) { //check up to sqrt(n)
-                if (n % i == 0 || n % (i + 2) == 0)
-                    return false;
+            size_t following = next(index);
+            while (slots[following].distance > 0) {
+                slots[index] = std::move(slots[following]);
+                slots[index].distance--;
+                index = following;
+                following = next(following);
             }
+            slots[index] = Slot(); // Empty the last slot of the shifted run
+            currentSize--;
             return true;
         }
-        // Helper function to find the next prime number greater than or equal to n
-        int nextPrime(int n) {
-            // If n is less than 1, return the first prime number (2)
-            if (n <= 1) return 2;
-            // If n is even, increment it by 1 to make it odd
-            if (n % 2 == 0) n++;
-            // Continue checking for primes starting from n
-            while (!isPrime(n)) {
-                n += 2; // Increment by 2 to skip even numbers
-            }
-            return n;
+
+    public:
+        /**
+         * @brief Constructs an empty Robin Hood table with room for about size keys (at most MAX_PRESIZE_KEYS)
+         */
+        explicit RobinHoodHashTable(size_t size = 101) : currentSize(0) {
+            size_t wanted = static_cast<size_t>(std::min(size, MAX_PRESIZE_KEYS) / LOAD_FACTOR) + 1;
+            allocate(std::bit_ceil(std::max(MIN_CAPACITY, wanted)));
+            //Change the seed everytime the new RobinHoodHashTable Object is created
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
         }
-        static constexpr double LOAD_FACTOR = 0.7; //Constant LOAD FACTOR
-        int tableSize;
-        int currentSize;
-        std::vector<HashEntry> table; // The underlying array represents the hash table
-        
 
         /**
-         * @brief Hash function for integers using a large prime constant derived from the golden ratio.
-         *
-         * This hash function takes an integer key and returns a hash value. It uses Knuth's multiplicative hashing technique,
-         * where the key is multiplied by a large prime constant (related to the golden ratio) and then modded by the table size.
-         * This method helps to distribute keys uniformly across the hash table, reducing the chances of collisions.
-         *
-         * @param key The integer key to be hashed.
-         * @return A hash value representing the index in the hash table for the given key.
+         * @brief Full hash code of a key (see KeyHash)
          */
-        template <typename T = KeyType>
-        typename std::enable_if<std::is_integral<T>::value, size_t>::type
-        hash(const T & key) const {
-            size_t largePrime = 2654435761;  // Prime constant (derived from golden ratio)
-            return (key * largePrime) % tableSize;
+        size_t hashCode(const KeyType & key) const {
+            return KeyHash::code(key);
         }
+
         /**
-         * @brief Hash function for strings using a polynomial rolling hash algorithm.
-         *
-         * This hash function computes a hash value for a string by treating it as a polynomial, where each character
-         * is assigned a weight based on its position in the string. The characters are processed from left to right,
-         * and each character is multiplied by a prime number base (37), ensuring that different permutations of the string
-         * result in different hash values.
-         *
-         * The function uses the modulo operation to keep the hash value within the bounds of the hash table, preventing overflow
-         * for large strings.
-         *
-         * @param key The string key to be hashed.
-         * @return A hash value representing the index in the hash table for the given string.
-        */
-        template <typename T = KeyType>
-        typename std::enable_if<std::is_same<T, std::string>::value, size_t>::type
-        hash(const T & key) const {
-            size_t hashVal = 5381;  // A more suitable starting value for djb2 hash
-            size_t prime = 33;  // A smaller prime number often used for hashing strings
-            
-            for (char ch : key) {
-                // Use bitwise left shift to amplify the effect of each character and add the character value
-                hashVal = ((hashVal*prime) + ch); 
-            }
-            
-            hashVal = hashVal % tableSize;  // Ensure it fits within the table size
-            //std::cout << "Hashing key: '" << key << "', Hash val: " << hashVal << std::endl;
-            
-            return hashVal;
+         * @brief Public insert method that calls the private insert function.
+         * @param k The key to be inserted.
+         * @param v The value associated with the key.
+         */
+        void insert(const KeyType & k, const ValueType & v) {
+            privateInsert(k, hashCode(k), v);
         }
+
         /**
-         * @brief Rehashes the hash table when the load factor becomes too high.
-         *
-         * This function increases the size of the hash table to the next prime number
-         * of double the old table size
-         * Perform reinserting all existing entries into the new table. 
+         * @brief Insert with a precomputed hash code (e.g. from a RollingHash over the window).
+         * @param k The key to be inserted.
+         * @param h The full hash code of k; must equal what hashCode(k) would return.
+         * @param v The value associated with the key.
          */
-        void rehash() {
-            std::vector<HashEntry> oldTable = table;  // Store the current table
+        void insert(const KeyType & k, size_t h, const ValueType & v) {
+            privateInsert(k, h, v);
+        }
 
-            // Increase table size to the next prime number roughly double the current size
-            tableSize = nextPrime(2 * tableSize);
-            table.resize(tableSize);  // Resize the table to the new size (table is std::vector)
+        /**
+         * @brief Returns the number of keys in the hash table.
+         */
+        int size() const {
+            return currentSize;
+        }
 
-            // Reinitialize all entries in the new table
-            for (auto &entry : table) {
-                entry.info = EMPTY;
-            }
+        /**
+         * @brief Checks if the hash table is empty.
+         */
+        bool empty() const {
+            return currentSize == 0;
+        }
 
-            // Reset currentSize to 0 because we will reinsert everything
-            currentSize = 0;
+        /**
+         * @brief Longest probe distance of any key currently in the table
+         */
+        int maxProbeDistance() const {
+            int longest = 0;
+            for (const auto & slot : slots) {
+                longest = std::max(longest, slot.distance);
+            }
+            return longest;
+        }
 
-            // Reinsert all active entries from the old table into the new table
-            for (const auto &entry : oldTable) {
-                if (entry.info == ACTIVE) {
-                    for (const auto &vc : entry.value_count) {
-                        //std::cout << "Rehashing key: '" << entry.key << "'" << std::endl;
-                        privateInsert(entry.key, vc.value);  // Rehash and reinsert the old key-value pair
-                    }
+        /**
+         * @brief Average probe distance over the keys currently in the table
+         */
+        double meanProbeDistance() const {
+            if (currentSize == 0) {
+                return 0.0;
+            }
+            long long total = 0;
+            for (const auto & slot : slots) {
+                if (slot.distance > 0) {
+                    total += slot.distance;
                 }
             }
+            return static_cast<double>(total) / currentSize;
         }
 
         /**
-         * @brief Insert a key-value pair into the hash table.
-         * Uses linear probing to resolve collisions.
-         * @param k The key to be inserted.
-         * @param v The value associated with the key.
+         * @brief Public method to find a key in the hash table and print its key and associated values with their counts.
+         * @param k The key to search for.
          */
-        void privateInsert(const KeyType & k, const ValueType & v) {
-            size_t index = hash(k); // Hash the key to an index
-            size_t firstDeleted = -1; // Track the first `DELETED` slot found during probing
-
-            //Perform linear probing to resolve collisions if the index already taken. table[index] is a HashEntry
-            while(table[index].info != EMPTY){
-                //If the index is already holding the key that is adding 
-                if((table[index].info == ACTIVE) && (table[index].key == k)){
-                    //Check if the value adding is already in the key -> increament
-                    for (auto & vc : table[index].value_count){
-                        if(vc.value == v){
-                            vc.count++;
-                            return;
-                        }
-                    }
-                    //If not just add a new value
-                    table[index].value_count.push_back(ValueCount(v, 1));
-                    return;
-                }
-                /**Record the first DELETED slot encountered. Continue searching to make sure we look at the entire table.
-                * If the key is not in the table we can insert at first deleted slot later after the loop is finish
-                */
-                if (table[index].info == DELETED && firstDeleted == -1) {
-                    firstDeleted = index;
+        void find(const KeyType & k) const {
+            size_t index = privateFind(k, hashCode(k));
+            if (index != capacity) {
+                std::cout << "Key: " << slots[index].key << "\nValues: ";
+                for (const auto& vc : slots[index].value_count) {
+                    std::cout << "[Value: '" << vc.value << "', Count: " << vc.count << "] ";
                 }
-                //If the index is not holding the same key that is adding -> Probing
-                index = (index + 1) % tableSize;
+                std::cout << std::endl;
+            } else {
+                std::cout << "Key '" << k << "' not found." << std::endl;
             }
-                // If a DELETED slot was found during probing, reuse it for the new entry
-                if (firstDeleted != -1) {
-                    index = firstDeleted;
-                }
+        }
 
-            
-            //After Checking. ie: found the index -> Add the HashEntry element to the index (new key only)
-            table[index] = HashEntry(k, v); //Default constructor will turn it to active
-            currentSize++; //increase the current size
+        /**
+         * @brief Public method to remove a key from the hash table.
+         * @param k The key to be removed.
+         * @throws std::runtime_error if the key is not found.
+         */
+        void remove(const KeyType k) {
+            if (!privateRemove(k)) {
+                throw std::runtime_error("Error: Key not found in the hash table.");
+            }
         }
 
         /**
-         * @brief Private method to find the index of a key in the hash table.
-         *
-         * This function performs linear probing to find the index of the given key.
-         * If the key is found and is ACTIVE, it returns the index of the entry; 
-         * if not, or if the key is marked as DELETED, it returns -1.
-         *
-         * @param k The key to search for.
-         * @return A pointer to the HashEntry if found and ACTIVE, nullptr otherwise.
+         * @brief Choose how getRandVal picks a weighted value (call before finalize())
          */
-        HashEntry* privateFind(const KeyType & k) {
-            size_t index = hash(k);  // Hash the key to an index
+        void setSampler(SamplerKind kind) {
+            sampler = kind;
+        }
 
-            // Perform linear probing to find the key
-            while (table[index].info != EMPTY) {  // Continue until an EMPTY slot is found
-                if ((table[index].info == ACTIVE) && (table[index].key == k)) {
-                    return &table[index];  // Return a pointer to the HashEntry if it's ACTIVE and matches the key
+        /**
+         * @brief Build the sampling structure (alias table or prefix sums) of every key once the model is complete.
+         * Keys inserted into afterwards are rebuilt lazily by their next getRandVal().
+         */
+        void finalize() {
+            for (size_t i = 0; i < capacity; i++) {
+                if (slots[i].distance >= 0) {
+                    slots[i].value_count.finalize(sampler);
                 }
-                // If the entry is DELETED or doesn't match, continue probing
-                index = (index + 1) % tableSize;
             }
-
-            return nullptr;  // Key not found
         }
+
         /**
-         * @brief Removes a key and its associated values from the hash table.
-         *
-         * This function searches for the key using `find()`. If the key is found, it marks the entry as `DELETED`
-         * and decrements `currentSize`. If the key is not found, an error condition is raised.
-         *
-         * @param k The key to be removed.
-         * @return True if the key was successfully removed, false if the key was not found.
+         * @brief Call visit(key, successors) for every key, in slot order
          */
-        bool privateRemove(const KeyType & k) {
-            HashEntry * entry = privateFind(k);
-            if (entry != nullptr) {
-                // Mark the entry as DELETED and adjust currentSize
-                entry->info = DELETED;
-                currentSize--;  // Decrement currentSize since the element is removed
-                return true;
-            } 
-            else {
-                return false;
+        template <typename Visitor>
+        void forEach(Visitor visit) const {
+            for (size_t i = 0; i < capacity; i++) {
+                if (slots[i].distance >= 0) {
+                    visit(slots[i].key, slots[i].value_count);
+                }
             }
         }
 
-         /**
-         * @brief Function to get a value of a given key randomly. 
-         * Value that has a higher count will has a higher chance of being returned.
-         * 
-         * @param Keytype & k key value
+        /**
+         * @brief Copy the keys and successors into a read-only FrozenModel (the table is unchanged)
+         */
+        FrozenModel<KeyType, ValueType> freeze() const {
+            return FrozenModel<KeyType, ValueType>(*this);
+        }
+
+        /**
+         * @brief Public method to get a random value weighted by the count
+         * @param Keytype & k
          * @return ValueType value
          */
-        std::mt19937 rand_num_gen;  // Each instance gets its own rng (random number generator). Seeding happens in the constructor
-        ValueType privateGetRandVal(const KeyType & k) {
-            HashEntry* entry = privateFind(k);
-            if (entry == nullptr) {
-                std::cerr << "Key not found in privateGetRandVal: \'" << k << "\'" << std::endl;
+        ValueType getRandVal(const KeyType & k) {
+            return getRandVal(k, hashCode(k));
+        }
+
+        /**
+         * @brief getRandVal with a precomputed hash code (e.g. from a RollingHash over the window)
+         * @param Keytype & k
+         * @param h The full hash code of k; must equal what hashCode(k) would return
+         * @return ValueType value
+         */
+        ValueType getRandVal(const KeyType & k, size_t h) {
+            size_t index = privateFind(k, h);
+            if (index == capacity) {
+                std::cerr << "Key not found in getRandVal: \'" << k << "\'" << std::endl;
                 throw std::runtime_error("Key not found");
             }
-            int totalWeight = 0;
-            //Calculate total weight
-            for (const auto& vc : entry->value_count) {
-                    totalWeight += vc.count;
-            }
-            // Generate a random number between 0 and totalWeight - 1
-            std::uniform_int_distribution<int> dist(0, totalWeight - 1);
-            int randNum = dist(rand_num_gen);
-            // Traverse the array and select the value based on the random number
-            int cumulativeWeight = 0;
-            for (const auto& vc : entry->value_count) {
-                cumulativeWeight += vc.count;
-                if (randNum < cumulativeWeight) {
-                    return vc.value; // Pick this value
-                }
-            }
-            // If we reach here, something went wrong, throw an exception
-            return ValueType(); //Fallback, though we should never reach here
+            return slots[index].value_count.sample(rand_num_gen, sampler);
         }
-       
 
         /**
-         * @brief Private method to display the contents of the hash table.
-         *
-         * This method iterates over the hash table and prints out the keys and associated values along with their counts.
-         * Only `ACTIVE` entries are displayed, while `EMPTY` and `DELETED` slots are skipped.
-         * This method is intended for internal use and should be called by the public `display()` method.
+         * @brief Display the keys with their probe distance and their values with counts, in slot order
          */
-        void privateDisplay() const {
-            for(size_t i = 0; i < tableSize; i++){
-                if(table[i].info == ACTIVE){
-                    std::cout << "Index: " << i << " | Key: \'" << table[i].key << "\'\n"; 
-                    for (const auto& vc : table[i].value_count) {
+        void display() const {
+            for (size_t i = 0; i < capacity; i++) {
+                if (slots[i].distance >= 0) {
+                    std::cout << "Index: " << i << " | Distance: " << slots[i].distance << " | Key: \'" << slots[i].key << "\'\n";
+                    for (const auto& vc : slots[i].value_count) {
                         std::cout << "[Value: \'" << vc.value << "\', Count: \'" << vc.count << "\'] ";
                     }
-                std::cout << std::endl;    
-                std::cout << std::endl;    
+                    std::cout << std::endl;
+                    std::cout << std::endl;
+                }
+            }
+        }
+};
+
+/**
+ * @class SuffixAutomaton
+ * @brief A variable-order model of the corpus: the suffix automaton, built in one pass.
+ *
+ * Each state stands for a set of substrings that end at the same corpus positions, so they have the same
+ * continuations: the weight of edge c out of a state is the number of occurrences of the edge's target state.
+ * Generation keeps the state of the current context and follows the sampled edge, so no window key is stored,
+ * hashed or compared. The context is capped at max_order characters by climbing suffix links, and when a
+ * context has no successors (it only ends the corpus) the longest shorter context that has some is used.
+ *
+ * During construction the edges are singly linked lists in one array; afterwards they are laid out per state
+ * (edgeStart) with running occurrence counts for sampling.
+ *
+ * An automaton of n characters has up to 2n states and 3n edges, so the indices are a template parameter:
+ * runAutomaton uses int while those fit in it, and std::int64_t beyond.
+ *
+ * @tparam Index A signed integer type for states, edges and lengths (-1 marks "none").
+ */
+template <typename Index>
+class SuffixAutomaton {
+    private:
+        using Count = std::make_unsigned_t<Index>; // Occurrence counts and edge offsets
+
+        std::vector<Index> length; // Length of the longest substring of each state
+        std::vector<Index> link; // Suffix link: the state of the longest suffix in another state (-1 for the root)
+        std::vector<Count> edgeStart; // Edges of state s are [edgeStart[s], edgeStart[s + 1])
+        std::vector<char> edgeChar;
+        std::vector<Index> edgeTarget;
+        std::vector<Count> edgeCumulative; // Running occurrence count of the targets within each state
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
+
+        // An edge while building: the next edge of the same state, or -1
+        struct BuildEdge {
+            char c;
+            Index target;
+            Index next;
+        };
+
+        // The edge c of state in the build lists, or -1
+        static Index findEdge(const std::vector<BuildEdge> & edges, const std::vector<Index> & firstEdge, Index state, char c) {
+            for (Index e = firstEdge[state]; e != -1; e = edges[e].next) {
+                if (edges[e].c == c) {
+                    return e;
+                }
+            }
+            return -1;
+        }
+
+        // The target of edge c of state in the final layout, or -1
+        Index transition(Index state, char c) const {
+            for (Count e = edgeStart[state]; e < edgeStart[state + 1]; e++) {
+                if (edgeChar[e] == c) {
+                    return edgeTarget[e];
                 }
             }
+            return -1;
+        }
+
+        // Climb to the state of the last max_order characters when the context is longer
+        Index capOrder(Index state, long long max_order) const {
+            while (link[state] != -1 && length[link[state]] >= max_order) {
+                state = link[state];
+            }
+            return state;
+        }
+
+        // Draw an edge of state, weighted by the occurrences of its target (the state has at least one edge)
+        Count sampleEdge(Index state) {
+            Count index = edgeStart[state];
+            Count count = edgeStart[state + 1] - index;
+            if (count == 1) {
+                return index; // Nothing to choose from
+            }
+            const Count* sums = edgeCumulative.data();
+            std::uniform_int_distribution<Count> dist(0, sums[index + count - 1] - 1);
+            Count randNum = dist(rand_num_gen);
+            // Branchless binary search: the answer stays in [index, index + count)
+            for (; count > 1; ) {
+                Count half = count / 2;
+                index = (sums[index + half - 1] <= randNum) ? index + half : index;
+                count -= half;
+            }
+            return index;
         }
 
     public:
         /**
-         * @brief Constructs an empty Hash Table
+         * @brief Build the automaton of the corpus; the corpus is not referenced afterwards
+         * @param corpus The mapped input file
          */
-        explicit HashTable(int size = 101) : tableSize(nextPrime(size)), currentSize(0), table(tableSize) {
-            //Change the seed everytime the new HashTable Object is created
+        explicit SuffixAutomaton(const MappedCorpus & corpus) {
             std::random_device ran_device;
             rand_num_gen.seed(ran_device()); //seed the rng
+
+            std::size_t maxStates = 2 * corpus.size() + 1;
+            length.reserve(maxStates);
+            link.reserve(maxStates);
+            std::vector<Index> firstEdge; // Head of each state's edge list while building
+            std::vector<Count> occurrences; // 1 for the state created by each character, 0 for clones
+            std::vector<BuildEdge> edges;
+            firstEdge.reserve(maxStates);
+            occurrences.reserve(maxStates);
+            edges.reserve(3 * corpus.size());
+            auto newState = [&](Index len, Index suffixLink, Count occurs) {
+                length.push_back(len);
+                link.push_back(suffixLink);
+                firstEdge.push_back(-1);
+                occurrences.push_back(occurs);
+                return static_cast<Index>(length.size()) - 1;
+            };
+            auto addEdge = [&](Index state, char c, Index target) {
+                edges.push_back({c, target, firstEdge[state]});
+                firstEdge[state] = static_cast<Index>(edges.size()) - 1;
+            };
+
+            Index last = newState(0, -1, 0); // The root: the empty string
+            for (char c : corpus) {
+                Index cur = newState(length[last] + 1, 0, 1);
+                Index p = last;
+                for (; p != -1 && findEdge(edges, firstEdge, p, c) == -1; p = link[p]) {
+                    addEdge(p, c, cur);
+                }
+                if (p != -1) {
+                    Index q = edges[findEdge(edges, firstEdge, p, c)].target;
+                    if (length[p] + 1 == length[q]) {
+                        link[cur] = q;
+                    } else {
+                        // q also holds longer strings: split off the ones up to length[p] + 1 into a clone
+                        Index clone = newState(length[p] + 1, link[q], 0);
+                        for (Index e = firstEdge[q]; e != -1; e = edges[e].next) {
+                            addEdge(clone, edges[e].c, edges[e].target);
+                        }
+                        for (Index e; p != -1 && (e = findEdge(edges, firstEdge, p, c)) != -1 && edges[e].target == q; p = link[p]) {
+                            edges[e].target = clone;
+                        }
+                        link[q] = clone;
+                        link[cur] = clone;
+                    }
+                }
+                last = cur;
+            }
+
+            // Occurrences of a state: its own plus those of every state whose suffix link leads to it (longest first)
+            std::vector<Index> byLength(length.size());
+            std::vector<Index> lengthCount(length[last] + 2, 0);
+            for (Index len : length) {
+                lengthCount[len + 1]++;
+            }
+            for (std::size_t i = 1; i < lengthCount.size(); i++) {
+                lengthCount[i] += lengthCount[i - 1];
+            }
+            for (std::size_t s = 0; s < length.size(); s++) {
+                byLength[lengthCount[length[s]]++] = static_cast<Index>(s);
+            }
+            for (std::size_t i = byLength.size() - 1; i > 0; i--) {
+                occurrences[link[byLength[i]]] += occurrences[byLength[i]];
+            }
+
+            // Lay the edges out per state, with running counts for sampling
+            edgeStart.reserve(length.size() + 1);
+            edgeChar.reserve(edges.size());
+            edgeTarget.reserve(edges.size());
+            edgeCumulative.reserve(edges.size());
+            for (std::size_t s = 0; s < length.size(); s++) {
+                edgeStart.push_back(static_cast<Count>(edgeChar.size()));
+                Count runningCount = 0;
+                for (Index e = firstEdge[s]; e != -1; e = edges[e].next) {
+                    runningCount += occurrences[edges[e].target];
+                    edgeChar.push_back(edges[e].c);
+                    edgeTarget.push_back(edges[e].target);
+                    edgeCumulative.push_back(runningCount);
+                }
+            }
+            edgeStart.push_back(static_cast<Count>(edgeChar.size()));
         }
 
-        /* ~HashTable() {
-            // Clear the table to ensure all entries are properly deallocated
-            table.clear(); 
-        } */
+        std::size_t size() const { return length.size(); }
 
+        /**
+         * @brief Bytes held by the automaton
+         */
+        std::size_t memoryBytes() const {
+            return (length.capacity() + link.capacity() + edgeTarget.capacity()) * sizeof(Index) + edgeChar.capacity()
+                 + (edgeStart.capacity() + edgeCumulative.capacity()) * sizeof(Count);
+        }
 
         /**
-         * @brief Public insert method that calls the private insert function.
-         * @param k The key to be inserted.
-         * @param v The value associated with the key.
+         * @brief Generate text with contexts of up to max_order characters
+         * @param outString Holds the start context (its last max_order characters are matched); values are appended to it
+         * @param max_order The longest context used (the window size)
+         * @param desired_length Number of characters to generate
          */
-        void insert(const KeyType & k, const ValueType & v) {
-            // Rehash if the load factor exceeds 0.7
-            if (this->currentSize >= this->LOAD_FACTOR * tableSize) {
-                rehash();
+        void generate(std::string & outString, long long max_order, long long desired_length) {
+            // Match the start context, falling back to shorter suffixes for characters it cannot extend
+            Index state = 0;
+            for (std::size_t i = outString.size() - std::min<std::size_t>(outString.size(), max_order); i < outString.size(); i++) {
+                Index next = transition(state, outString[i]);
+                while (next == -1 && state != 0) {
+                    state = link[state];
+                    next = transition(state, outString[i]);
+                }
+                state = (next == -1) ? 0 : capOrder(next, max_order);
+            }
+
+            while (outString.length() <= static_cast<std::size_t>(desired_length)) {
+                // Back off to the longest suffix of the context that has successors
+                while (edgeStart[state] == edgeStart[state + 1]) {
+                    state = link[state];
+                }
+                Count edge = sampleEdge(state);
+                outString += edgeChar[edge];
+                state = capOrder(edgeTarget[edge], max_order);
+            }
+        }
+};
+
+/**
+ * @class DenseModel
+ * @brief A model for tiny windows: running successor counts in one flat array, indexed directly by the context.
+ *
+ * The corpus bytes are first remapped to their rank in the corpus' symbol set (an alphabet of A symbols), so a
+ * context of W symbols is a number below A^W, updated in O(1) as the window slides, and row c of the array holds
+ * the running counts of the A possible successors of context c. A lookup is one multiply-add and one row read:
+ * nothing is hashed, compared or probed. The array has A^(W+1) cells whether or not a context occurs, so it only
+ * pays off while that fits in memory (a few MiB for W = 3 on merchant.txt's 28 symbols).
+ */
+class DenseModel {
+    private:
+        std::array<std::uint8_t, 256> symbolOf; // Rank of each byte in the alphabet (0 for bytes not in the corpus)
+        std::string symbols; // The alphabet: symbols[rank] is the byte
+        std::size_t contextCount; // A^W
+        std::vector<std::uint32_t> cumulative; // Row c: running counts of the successors of context c (last = total)
+        std::size_t usedContexts; // Contexts that have at least one successor
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
+
+        // Number of cells of the array for an alphabet and window size, or 0 if it does not fit in a size_t
+        static std::size_t cellCount(std::size_t alphabet, long long window_size) {
+            std::size_t cells = 1;
+            for (long long i = 0; i <= window_size; i++) {
+                if (cells > std::numeric_limits<std::size_t>::max() / alphabet) {
+                    return 0;
+                }
+                cells *= alphabet;
+            }
+            return cells;
+        }
+
+        // Draw a successor rank of context, weighted by the count (the context has at least one successor)
+        std::size_t sample(std::size_t context) {
+            const std::uint32_t* sums = cumulative.data() + context * symbols.size();
+            std::uniform_int_distribution<std::uint32_t> dist(0, sums[symbols.size() - 1] - 1);
+            std::uint32_t randNum = dist(rand_num_gen);
+            // Branchless binary search: the answer stays in [index, index + count)
+            std::size_t index = 0;
+            for (std::size_t count = symbols.size(); count > 1; ) {
+                std::size_t half = count / 2;
+                index = (sums[index + half - 1] <= randNum) ? index + half : index;
+                count -= half;
+            }
+            return index;
+        }
+
+    public:
+        /**
+         * @brief The symbols of the corpus in byte order (one pass over the corpus)
+         */
+        static std::string alphabetOf(const MappedCorpus & corpus) {
+            std::array<bool, 256> present{};
+            for (char c : corpus) {
+                present[static_cast<unsigned char>(c)] = true;
+            }
+            std::string alphabet;
+            for (int b = 0; b < 256; b++) {
+                if (present[b]) {
+                    alphabet += static_cast<char>(b);
+                }
+            }
+            return alphabet;
+        }
+
+        /**
+         * @brief Bytes the array would take for this alphabet and window size, without building it
+         * @param alphabet_size Number of symbols in the corpus (see alphabetOf())
+         * @return The size in bytes, or SIZE_MAX if it would not even be addressable
+         */
+        static std::size_t requiredBytes(std::size_t alphabet_size, long long window_size) {
+            std::size_t cells = cellCount(alphabet_size, window_size);
+            if (cells == 0 || cells > std::numeric_limits<std::size_t>::max() / sizeof(std::uint32_t)) {
+                return std::numeric_limits<std::size_t>::max();
             }
-            privateInsert(k, v);
+            return cells * sizeof(std::uint32_t);
         }
+
         /**
-         * @brief Returns the number of active elements in the hash table.
-         *
-         * @return The number of active elements in the hash table.
+         * @brief Count every (window, next character) pair of the corpus; the corpus is not referenced afterwards
+         * @param corpus The mapped input file
+         * @param corpus_symbols The symbols of the corpus, from alphabetOf(corpus)
+         * @param window_size Number of characters in a context (check requiredBytes() first)
          */
-        int size() const {
-            return this->currentSize;
+        DenseModel(const MappedCorpus & corpus, std::string corpus_symbols, long long window_size)
+            : symbolOf{}, symbols(std::move(corpus_symbols)), usedContexts(0) {
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+
+            for (std::size_t rank = 0; rank < symbols.size(); rank++) {
+                symbolOf[static_cast<unsigned char>(symbols[rank])] = static_cast<std::uint8_t>(rank);
+            }
+            std::size_t alphabet = symbols.size();
+            contextCount = cellCount(alphabet, window_size) / alphabet;
+            cumulative.assign(contextCount * alphabet, 0);
+
+            // Slide the window, counting each successor in the row of its context
+            std::size_t context = 0;
+            for (long long i = 0; i < window_size; i++) {
+                context = context * alphabet + symbolOf[static_cast<unsigned char>(corpus.data()[i])];
+            }
+            for (const char* next = corpus.begin() + window_size; next < corpus.end(); next++) {
+                std::size_t symbol = symbolOf[static_cast<unsigned char>(*next)];
+                cumulative[context * alphabet + symbol]++;
+                context = (context * alphabet + symbol) % contextCount; // The oldest symbol drops out
+            }
+
+            // Turn each row of counts into running counts for sampling
+            for (std::size_t row = 0; row < cumulative.size(); row += alphabet) {
+                for (std::size_t j = 1; j < alphabet; j++) {
+                    cumulative[row + j] += cumulative[row + j - 1];
+                }
+                usedContexts += (cumulative[row + alphabet - 1] != 0);
+            }
         }
 
+        // Number of contexts that occur in the corpus (followed by a character)
+        std::size_t size() const { return usedContexts; }
+
         /**
-         * @brief Checks if the hash table is empty.
-         *
-         * This function returns true if the hash table contains no elements, i.e., if the `currentSize`
-         * is zero. It provides a convenient way to check if the hash table is currently empty.
-         *
-         * @return True if the hash table is empty, false otherwise.
+         * @brief Bytes held by the model
          */
-        bool empty() const {
-            return currentSize == 0;
+        std::size_t memoryBytes() const {
+            return cumulative.capacity() * sizeof(std::uint32_t) + sizeof(symbolOf) + symbols.capacity();
         }
+
         /**
-         * @brief Public method to find a key in the hash table and print its key and associated values with their counts.
-         *
-         * This method calls the `privateFind()` function. If the key is found and ACTIVE, it prints the key and its associated
-         * values with their counts.
-         *
-         * @param k The key to search for.
+         * @brief Generate text from the context of the last <Window-Size> characters
+         * @param outString Holds the start context (characters from the corpus); generated characters are appended to it
+         * @param window_size Number of characters in a context
+         * @param desired_length Number of characters to generate
+         * @throws std::runtime_error if a context on the way has no successor (outString keeps what was generated)
          */
-        void find(const KeyType & k) const {
-            //Const cast the return value of 'privateFind' to remain encapsulation
-            const HashEntry* entry = const_cast<const HashEntry*>(const_cast<HashTable*>(this)->privateFind(k)); 
-            
-            if (entry != nullptr) {
-                std::cout << "Key: " << entry->key << "\nValues: ";
-                for (const auto& vc : entry->value_count) {
-                    std::cout << "[Value: '" << vc.value << "', Count: " << vc.count << "] ";
+        void generate(std::string & outString, long long window_size, long long desired_length) {
+            std::size_t alphabet = symbols.size();
+            std::size_t context = 0;
+            for (std::size_t i = outString.size() - window_size; i < outString.size(); i++) {
+                context = context * alphabet + symbolOf[static_cast<unsigned char>(outString[i])];
+            }
+            while (outString.length() <= static_cast<std::size_t>(desired_length)) {
+                if (cumulative[context * alphabet + alphabet - 1] == 0) {
+                    throw std::runtime_error("Key not found");
                 }
-                std::cout << std::endl;
-            } else {
-                std::cout << "Key '" << k << "' not found." << std::endl;
+                std::size_t symbol = sample(context);
+                outString += symbols[symbol];
+                context = (context * alphabet + symbol) % contextCount;
             }
         }
+};
+
+// Helper functions to view the characters of a key, whatever its type
+std::string_view keyBytes(const CorpusKey & key) { return std::string_view(key.bytes, key.length); }
+std::string_view keyBytes(const std::string & key) { return key; }
+template <std::size_t W>
+std::string_view keyBytes(const std::array<char, W> & key) { return std::string_view(key.data(), W); }
+
+/**
+ * @class CompiledModel
+ * @brief A built model compiled into a state machine for generation.
+ *
+ * Each context (key) of the model becomes a state. For every successor value of a state, the constructor stores
+ * the index of the state whose context follows: the context without its first characters, plus the value.
+ * Generation is then sampling plus following that index, with no key built, hashed or compared per character.
+ *
+ * The edges are kept in one flat array: the next states of state s are nextState[firstEdge[s] .. firstEdge[s + 1]),
+ * in the order of the successors of s.
+ *
+ * @tparam ValueType The data type of the values associated with each key.
+ */
+template <typename ValueType>
+class CompiledModel {
+    public:
+        static constexpr std::uint32_t NO_STATE = std::numeric_limits<std::uint32_t>::max(); // The context is not in the model
+
+    private:
+        std::vector<SuccessorList<ValueType>> states; // Successors of each state, with their sampling structure built
+        std::vector<std::uint32_t> firstEdge; // Index of the first edge of each state in nextState, plus one past the end
+        std::vector<std::uint32_t> nextState; // State reached by each successor, or NO_STATE at the end of the corpus
+        std::unordered_map<std::string_view, std::uint32_t> stateOf; // Context characters -> state (views into the model keys)
+        SamplerKind sampler;
+        std::mt19937 rand_num_gen;  // Seeding happens in the constructor
+
+    public:
         /**
-         * @brief Public method to remove a key from the hash table.
-         *
-         * This method calls the `privateRemove()` function. If the key is not found, it throws a `std::runtime_error`.
-         * Otherwise, the key is removed from the hash table.
-         *
-         * @param k The key to be removed.
-         * @throws std::runtime_error if the key is not found.
+         * @brief Compile a finished model (HashTable, SwissHashTable or RobinHoodHashTable)
+         * The keys of the model must stay alive (and unchanged) as long as this object is used.
+         * @param model The model to compile; it is only read
+         * @param kind How successors are sampled
+         * @throws std::runtime_error if the model has more states or edges than 32-bit indices can hold
          */
-        void remove(const KeyType k) {
-            if (!privateRemove(k)) {
-                throw std::runtime_error("Error: Key not found in the hash table.");
+        template <typename Model>
+        CompiledModel(const Model & model, SamplerKind kind) : sampler(kind) {
+            std::random_device ran_device;
+            rand_num_gen.seed(ran_device()); //seed the rng
+
+            // States and edges are indexed in 32 bits, with NO_STATE reserved
+            std::size_t stateTotal = 0, edgeTotal = 0;
+            model.forEach([&](const auto &, const SuccessorList<ValueType> & successors) {
+                stateTotal++;
+                edgeTotal += successors.size();
+            });
+            if (stateTotal >= NO_STATE || edgeTotal > std::numeric_limits<std::uint32_t>::max()) {
+                std::cerr << "Model too large to compile: " << stateTotal << " states, " << edgeTotal << " edges" << std::endl;
+                throw std::runtime_error("Model too large to compile");
+            }
+
+            // Number the contexts
+            std::vector<std::string_view> contexts;
+            model.forEach([&](const auto & key, const SuccessorList<ValueType> & successors) {
+                stateOf.emplace(keyBytes(key), static_cast<std::uint32_t>(states.size()));
+                contexts.push_back(keyBytes(key));
+                states.push_back(successors);
+                states.back().finalize(sampler);
+            });
+
+            // Resolve every successor to the state of its next context, once
+            firstEdge.reserve(states.size() + 1);
+            std::string next;
+            for (std::size_t s = 0; s < states.size(); s++) {
+                firstEdge.push_back(static_cast<std::uint32_t>(nextState.size()));
+                for (std::size_t j = 0; j < states[s].size(); j++) {
+                    next.assign(contexts[s]);
+                    next += states[s].valueAt(j);
+                    nextState.push_back(findState(std::string_view(next).substr(next.size() - contexts[s].size())));
+                }
             }
+            firstEdge.push_back(static_cast<std::uint32_t>(nextState.size()));
         }
+
         /**
-         * @brief Public method to get a random value weighted by the count
-         * Function is marked as const to ensure no modification is performed on the Tree Structure
-         * @param Keytype & k
-         * @return ValueType value
+         * @brief The state of a context, or NO_STATE if the model does not contain it
          */
-        ValueType getRandVal(const KeyType & k){
-            return privateGetRandVal(k);
+        std::uint32_t findState(std::string_view context) const {
+            auto found = stateOf.find(context);
+            return (found == stateOf.end()) ? NO_STATE : found->second;
         }
 
+        std::size_t size() const { return states.size(); }
+
         /**
-         * @brief Public display method that calls the private display function.
+         * @brief Generate text by walking the state machine from the state of the last <Window-Size> characters
+         * @param outString Holds the start context; generated values are appended to it
+         * @param window_size Number of characters in a context
+         * @param desired_length Number of characters to generate
+         * @throws std::runtime_error if a context on the way is not in the model (outString keeps what was generated)
          */
-        void display() const {
-            privateDisplay();
+        void generate(std::string & outString, long long window_size, long long desired_length) {
+            std::uint32_t state = findState(std::string_view(outString).substr(outString.size() - window_size));
+            while (outString.length() <= static_cast<std::size_t>(desired_length)) {
+                if (state == NO_STATE) {
+                    throw std::runtime_error("Key not found");
+                }
+                std::size_t j = states[state].sampleIndex(rand_num_gen, sampler);
+                outString += states[state].valueAt(j);
+                state = nextState[firstEdge[state] + j];
+            }
         }
-
 };
 
 // Helper function to check if input is a valid integer and within the range
@@ -472,8 +2775,377 @@ bool isValidInteger(const std::string& input, long long& value) {
     return true;
 }
 
+/**
+ * @brief Slide a window over the corpus and insert every (window, next character) pair into the table
+ * @tparam Window The window policy (CorpusWindow, or PackedWindow for short windows); it must match the table's keys
+ * @param table The hash table engine to fill (HashTable, SwissHashTable or RobinHoodHashTable)
+ * @param corpus The mapped input file; stored CorpusKeys point into it
+ * @param window_size Number of characters in a window
+ */
+template <typename Window, typename Table>
+void buildModel(Table & table, const MappedCorpus & corpus, long long window_size) {
+    char peek_char;
+    // The window is a moving offset into the corpus: advancing it is O(1) whatever the window size
+    const char* window = corpus.begin();
+    const char* last_window = corpus.end() - window_size; // The final window has no next character to record
+    Window current(window, window_size); // Key and hash of the current window, updated in O(1) per step
+
+    // Slide the window through the corpus, one character at a time
+    for (; window < last_window; window++) {
+        peek_char = window[window_size]; // The next character follows the window directly in the corpus
+        //Insert to the Hash Table
+        table.insert(current.key(window), current.hash(), peek_char);
+        current.roll(window[0], peek_char); // The next character enters the window, the first one leaves
+    }
+}
+
+/**
+ * @brief Generate text from the model, starting with the first window of the corpus
+ * @tparam Window The window policy the model was built with
+ * @param table The filled hash table engine, or a FrozenModel
+ * @param firstString The first <Window-Size> characters of the corpus
+ * @param window_size Number of characters in a window
+ * @param desired_length Number of characters to generate
+ * @return The generated text
+ */
+template <typename Window, typename Table>
+std::string generateText(Table & table, const std::string & firstString, long long window_size, long long desired_length) {
+    std::string outString = firstString;
+    outString.reserve(desired_length + 2); // Avoid regrowing the output while generating
+    // The window is the last <Window-Size> characters of outString, tracked by its start offset
+    std::size_t window_start = 0;
+    Window current(outString.data(), window_size); // Key and hash of the window, updated in O(1) per step
+
+    try {
+        char toAdd = table.getRandVal(current.key(outString.data()), current.hash());
+
+        while (outString.length() <= desired_length) {
+            // Append to outString
+            outString += toAdd;
+
+            // Advance the window past the appended character instead of erasing its first character
+            current.roll(outString[window_start], toAdd);
+            window_start++;
+
+            // Get the next random value for the current window (a CorpusKey views it in outString, nothing is copied)
+            toAdd = table.getRandVal(current.key(outString.data() + window_start), current.hash());
+        }
+    } catch (const std::runtime_error &e) {
+        std::cout << "Caught runtime_error: " << e.what() << std::endl;
+    }
+
+    //outString.pop_back(); outString.pop_back();  // Remove any garbage characters
+
+    //std::cout << "====Final String====" << std::endl;
+    //std::cout << "'" << outString << "'\n";
+    return outString;
+}
+
+// Helper function to write the generated text to out.txt; returns the exit code for main
+int exportOutput(const std::string & outString) {
+    // Create and open the output file
+    std::ofstream outfile("out.txt");  
+    if (!outfile) {
+        std::cerr << "Error creating output file!" << std::endl;
+        return 1;
+    }
+    // Write outString to the file
+    outfile << outString;
+    outfile.close();
+    std::cout << "====Result exported to 'out.txt' file successfully!====" << std::endl;
+
+    return 0;
+}
+
+/**
+ * @brief How runModel serves and reports a model (set from the command line flags)
+ */
+struct RunOptions {
+    SamplerKind sampler = ALIAS_SAMPLER; // How successors are sampled
+    bool timed = false; // Print how long each phase took (to compare table engines)
+    bool compiled = false; // Generate from a CompiledModel state machine
+    bool frozen = false; // Generate from a FrozenModel, releasing the table once it is frozen
+};
+
+/**
+ * @brief Build the model in the given table, generate the output and export it to out.txt
+ * @tparam Window The window policy; its KeyType is the table's key type. Keys without keyBytes() (packed integers)
+ * can not be compiled
+ * @param table The empty table engine; runModel owns it so that a frozen run can release it
+ * @param options How to sample, serve and report
+ * @return The exit code for main
+ */
+template <typename Window, typename Table>
+int runModel(std::unique_ptr<Table> table, const MappedCorpus & corpus, long long window_size, long long desired_length, const RunOptions & options) {
+    auto start = std::chrono::steady_clock::now();
+    table->setSampler(options.sampler);
+    buildModel<Window>(*table, corpus, window_size);
+    if (!options.frozen) {
+        table->finalize(); // Build the alias tables (or prefix sums) for sampling
+    }
+    std::size_t keys = table->size();
+    auto built = std::chrono::steady_clock::now();
+    /* table->display();
+    std::cout << "GET RAND VAR" << std::endl;
+    std::string key = "\n";
+    std::cout << "Key: \'" << key << "\' | Value: \'" <<table->getRandVal(std::string(key)) << "\'" << std::endl;  */
+    //===================DONE STORING INPUT=====================//
+    // Work on the output
+    std::string firstString(corpus.data(), window_size);
+    std::string outString;
+    std::size_t frozen_bytes = 0;
+    // The compiled and frozen models are torn down at the end of their block: take generated inside it, so that
+    // --time reports generation only
+    auto generating = built;
+    auto generated = built;
+    if (options.compiled) {
+        // The state machine resolves contexts by their characters, so it needs keys that keyBytes() can view
+        if constexpr (requires (const typename Window::KeyType & k) { keyBytes(k); }) {
+            std::optional<CompiledModel<char>> machine;
+            try {
+                machine.emplace(*table, options.sampler);
+            } catch (const std::runtime_error &) {
+                return 1; // The model was too large for 32-bit state indices; the reason is already printed
+            }
+            generating = std::chrono::steady_clock::now();
+            outString.reserve(desired_length + 2); // Avoid regrowing the output while generating
+            outString = firstString;
+            try {
+                machine->generate(outString, window_size, desired_length);
+            } catch (const std::runtime_error &e) {
+                std::cout << "Caught runtime_error: " << e.what() << std::endl;
+            }
+            generated = std::chrono::steady_clock::now();
+        } else {
+            std::cerr << "Error: --compile needs keys that view their characters (--key=fixed or --key=corpus)" << std::endl;
+            return 1;
+        }
+    } else if (options.frozen) {
+        std::optional<FrozenModel<typename Window::KeyType, char>> model;
+        try {
+            model.emplace(table->freeze());
+        } catch (const std::runtime_error &) {
+            return 1; // The model was too large for the frozen arrays; the reason is already printed
+        }
+        table.reset(); // Only the frozen arrays (and the corpus their keys view) are needed from here on
+        frozen_bytes = model->memoryBytes();
+        generating = std::chrono::steady_clock::now();
+        outString = generateText<Window>(*model, firstString, window_size, desired_length);
+        generated = std::chrono::steady_clock::now();
+    } else {
+        generating = std::chrono::steady_clock::now();
+        outString = generateText<Window>(*table, firstString, window_size, desired_length);
+        generated = std::chrono::steady_clock::now();
+    }
+
+    if (options.timed) {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        std::cout << "Keys: " << keys
+                  << " | Ingestion: " << duration_cast<milliseconds>(built - start).count() << " ms";
+        if (options.compiled) {
+            std::cout << " | Compile: " << duration_cast<milliseconds>(generating - built).count() << " ms";
+        }
+        if (options.frozen) {
+            std::cout << " | Freeze: " << duration_cast<milliseconds>(generating - built).count() << " ms"
+                      << " (" << frozen_bytes / 1024 << " KiB)";
+        }
+        std::cout << " | Generation: " << duration_cast<milliseconds>(generated - generating).count() << " ms" << std::endl;
+        if constexpr (requires { table->maxProbeDistance(); }) {
+            if (table) {
+                std::cout << "Max probe distance: " << table->maxProbeDistance()
+                          << " | Mean probe distance: " << table->meanProbeDistance() << std::endl;
+            }
+        }
+    }
+
+    return exportOutput(outString);
+}
+
+/**
+ * @brief Run the table engine chosen on the command line, with keys of the window policy's key type
+ * @param table_kind linear, swiss or robinhood
+ * @param sizing_kind pow2 or prime (linear table only)
+ * @return The exit code for main
+ */
+template <typename Window>
+int runTable(const std::string & table_kind, const std::string & sizing_kind, const MappedCorpus & corpus, long long window_size, long long desired_length, const RunOptions & options) {
+    using Key = typename Window::KeyType;
+    // There are at most as many distinct keys as windows in the corpus; the table grows past the estimate if needed
+    std::size_t capacity = std::min(corpus.size() - static_cast<std::size_t>(window_size), MAX_PRESIZE_KEYS);
+    if (table_kind == "swiss") {
+        return runModel<Window>(std::make_unique<SwissHashTable<Key,char>>(capacity), corpus, window_size, desired_length, options);
+    }
+    if (table_kind == "robinhood") {
+        return runModel<Window>(std::make_unique<RobinHoodHashTable<Key,char>>(capacity), corpus, window_size, desired_length, options);
+    }
+    if (sizing_kind == "prime") {
+        return runModel<Window>(std::make_unique<HashTable<Key,char,PrimeSizing>>(capacity), corpus, window_size, desired_length, options);
+    }
+    return runModel<Window>(std::make_unique<HashTable<Key,char>>(capacity), corpus, window_size, desired_length, options);
+}
+
+/**
+ * @brief Build a SuffixAutomaton of the corpus, generate with contexts of up to window_size characters and export
+ * the output to out.txt
+ * @tparam Index The automaton's state and edge index type (see SuffixAutomaton)
+ * @param options Only timed is used: the automaton samples by running counts and is neither compiled nor frozen
+ * @return The exit code for main
+ */
+template <typename Index>
+int runAutomaton(const MappedCorpus & corpus, long long window_size, long long desired_length, const RunOptions & options) {
+    auto start = std::chrono::steady_clock::now();
+    SuffixAutomaton<Index> automaton(corpus);
+    auto built = std::chrono::steady_clock::now();
+    std::string outString;
+    outString.reserve(desired_length + 2); // Avoid regrowing the output while generating
+    outString.assign(corpus.data(), window_size);
+    automaton.generate(outString, window_size, desired_length);
+    auto generated = std::chrono::steady_clock::now();
+
+    if (options.timed) {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        std::cout << "States: " << automaton.size() << " (" << automaton.memoryBytes() / 1024 << " KiB)"
+                  << " | Ingestion: " << duration_cast<milliseconds>(built - start).count() << " ms"
+                  << " | Generation: " << duration_cast<milliseconds>(generated - built).count() << " ms" << std::endl;
+    }
+    return exportOutput(outString);
+}
+
+/**
+ * @brief Build a DenseModel of the corpus, generate the output and export it to out.txt
+ * @param alphabet The symbols of the corpus, from DenseModel::alphabetOf(corpus)
+ * @param options Only timed is used: the dense rows are sampled directly and are neither compiled nor frozen
+ * @return The exit code for main
+ */
+int runDense(const MappedCorpus & corpus, std::string alphabet, long long window_size, long long desired_length, const RunOptions & options) {
+    auto start = std::chrono::steady_clock::now();
+    DenseModel model(corpus, std::move(alphabet), window_size);
+    auto built = std::chrono::steady_clock::now();
+    std::string outString;
+    outString.reserve(desired_length + 2); // Avoid regrowing the output while generating
+    outString.assign(corpus.data(), window_size);
+    try {
+        model.generate(outString, window_size, desired_length);
+    } catch (const std::runtime_error &e) {
+        std::cout << "Caught runtime_error: " << e.what() << std::endl;
+    }
+    auto generated = std::chrono::steady_clock::now();
+
+    if (options.timed) {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        std::cout << "Keys: " << model.size() << " (dense, " << model.memoryBytes() / 1024 << " KiB)"
+                  << " | Ingestion: " << duration_cast<milliseconds>(built - start).count() << " ms"
+                  << " | Generation: " << duration_cast<milliseconds>(generated - built).count() << " ms" << std::endl;
+    }
+    return exportOutput(outString);
+}
+
+/**
+ * @brief Time the three samplers on synthetic contexts with 1, 8, 64 and 256 successors.
+ * Counts are random in [1, 100]; every sampler draws the same number of values from the same list.
+ */
+void benchmarkSamplers() {
+    const int SAMPLES = 5000000;
+    std::mt19937 rand_num_gen(12345);
+    std::uniform_int_distribution<int> countDist(1, 100);
+    const std::pair<SamplerKind, const char*> samplers[] = {{SCAN_SAMPLER, "scan"}, {ALIAS_SAMPLER, "alias"}, {PREFIX_SAMPLER, "prefix"}};
+    for (int successors : {1, 8, 64, 256}) {
+        SuccessorList<int> list;
+        for (int value = 0; value < successors; value++) {
+            int count = countDist(rand_num_gen);
+            for (int c = 0; c < count; c++) {
+                list.add(value);
+            }
+        }
+        std::cout << "Successors: " << successors;
+        for (const auto & [kind, name] : samplers) {
+            list.finalize(kind);
+            long long checksum = 0; // Keeps the samples from being optimized away
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < SAMPLES; i++) {
+                checksum += list.sample(rand_num_gen, kind);
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            std::cout << " | " << name << ": " << static_cast<double>(elapsed) / SAMPLES << " ns" << (checksum < 0 ? "!" : "");
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Helper function to read a "--name=value" command line option, or fallback if it is not given
+std::string getOption(int argc, char* argv[], const std::string & name, const std::string & fallback) {
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, prefix.size(), prefix) == 0) {
+            return arg.substr(prefix.size());
+        }
+    }
+    return fallback;
+}
+
+// Helper function to check if a "--name=value" command line option is given, whatever its value
+bool hasOption(int argc, char* argv[], const std::string & name) {
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]).compare(0, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Helper function to check if a "--name" command line flag is given
+bool hasFlag(int argc, char* argv[], const std::string & name) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--" + name) {
+            return true;
+        }
+    }
+    return false;
+}
+
 //=====MAIN PROGRAM=====//
-int main(){
+// Options: --model=auto|table|automaton|dense: automaton replaces the hash table with a SuffixAutomaton (window
+// size = maximum context length), dense with a DenseModel; auto (default) picks dense when it fits the budget
+// and no table option (--table, --sizing, --sampler, --key, --compile, --freeze) is given, which dense rejects,
+// --dense-budget=<MiB> the most memory the automatic choice gives a DenseModel (default 64),
+// --table=linear|swiss|robinhood selects the hash table engine (default linear),
+// --sizing=pow2|prime the sizing policy of the linear table (default pow2),
+// --sampler=alias|prefix|scan how successors are sampled (default alias),
+// --key=packed|fixed|corpus packs windows of up to 16 characters into integer keys (default), uses std::array keys
+// for window sizes 3, 5, 8 and 12, or always uses CorpusKeys (other sizes with fixed, and compiled runs with packed),
+// --compile generates from a CompiledModel state machine instead of table lookups (always with CorpusKeys),
+// --freeze generates from a FrozenModel (flat sorted arrays) and releases the table, --time prints timings,
+// --bench-sampler only runs the sampler benchmark
+int main(int argc, char* argv[]){
+    std::string model_kind = getOption(argc, argv, "model", "auto");
+    std::string table_kind = getOption(argc, argv, "table", "linear");
+    std::string sizing_kind = getOption(argc, argv, "sizing", "pow2");
+    std::string sampler_kind = getOption(argc, argv, "sampler", "alias");
+    std::string key_kind = getOption(argc, argv, "key", "packed");
+    // Options that only a table model uses: they select a table run instead of an automatic dense one
+    bool table_options = hasOption(argc, argv, "table") || hasOption(argc, argv, "sizing") || hasOption(argc, argv, "sampler") ||
+                         hasOption(argc, argv, "key") || hasFlag(argc, argv, "compile") || hasFlag(argc, argv, "freeze");
+    long long dense_budget = 0;
+    if ((model_kind != "auto" && model_kind != "table" && model_kind != "automaton" && model_kind != "dense") ||
+        !isValidInteger(getOption(argc, argv, "dense-budget", "64"), dense_budget) ||
+        (key_kind != "packed" && key_kind != "fixed" && key_kind != "corpus") ||
+        (table_kind != "linear" && table_kind != "swiss" && table_kind != "robinhood") ||
+        (sizing_kind != "pow2" && sizing_kind != "prime") ||
+        (sampler_kind != "alias" && sampler_kind != "prefix" && sampler_kind != "scan") ||
+        (hasFlag(argc, argv, "compile") && hasFlag(argc, argv, "freeze")) ||
+        (model_kind == "dense" && table_options)) {
+        std::cerr << "Usage: " << argv[0] << " [--model=auto|table|automaton|dense] [--dense-budget=<MiB>] [--table=linear|swiss|robinhood] [--sizing=pow2|prime] [--sampler=alias|prefix|scan] [--key=packed|fixed|corpus] [--compile | --freeze] [--time] [--bench-sampler]" << std::endl;
+        return 1;
+    }
+    if (hasFlag(argc, argv, "bench-sampler")) {
+        benchmarkSamplers();
+        return 0;
+    }
     std::string window_size_str, desired_length_str;
     long long window_size = 0;
     long long desired_length = 0;
@@ -524,109 +3196,63 @@ int main(){
         std::cerr << "Invalid input: <Window-Size> must be smaller than <Input-File-Length> (merchant.txt length)" << std::endl;
         return 1;
     }
+    file.close(); // The probe stream is only used for the length; the bytes are read through the mapping
     //===========================================================//
 
-    HashTable<std::string,std::string> stringTable(infile_length);//Declare the Hash table structure and initialize the length = file length
-    
-    char next_char;
-    char peek_char;
-    char* buffer = new char[window_size + 1]; // Create a buffer to hold the window
-    // Pre-fill the buffer with the first 'window_size' characters
-    for (int i = 0; i < window_size; i++) {
-        if (file.get(next_char)) {
-            // Replace newline or tab with a space
-            /* if (next_char == '\n' || next_char == '\t') {
-                next_char = ' ';
-            } */
-            buffer[i] = next_char;
-        } else {
-            break; // If the file has fewer characters than the window size
-        }
-    }
-    buffer[window_size] = '\0'; // Null-terminate the buffer to treat it as a C-string
-    //NOTE: Save the first string to use for output later
-    std::string firstString(buffer);
-    // Peek the next character in the file stream without extracting it
-    peek_char = file.peek();
-    //Insert to the Hash Table
-    stringTable.insert(std::string(buffer),std::string(1,peek_char));
-
-    // Slide the window through the file, one character at a time
-    while (file.get(next_char)) {
-        // Replace newline or tab with a space
-        /* if (next_char == '\n' || next_char == '\t') {
-            next_char = ' ';
-        } */
-        // Shift the buffer to the left by 1 and append the new character
-        for (int i = 0; i < window_size - 1; i++) {
-            buffer[i] = buffer[i + 1];
-        }
-        buffer[window_size - 1] = next_char; //get the next char
-
-        
-        peek_char = file.peek();
-        // Check if peek() has returned EOF
-        if (peek_char == EOF) {
-            break; // Exit the loop if we're at the end of the file
-        }
-        // Output the current window
-        /* std::cout << "Insert Key: \'" << buffer <<"\'" << std::endl;
-        std::cout << "Value: \'" << peek_char <<"\'" << std::endl; */
-        //Insert to the Hash Table
-        stringTable.insert(std::string(buffer),std::string(1,peek_char));
-    }
-    
-    file.close();
-    delete[] buffer; // Clean up dynamically allocated memory
-    /* stringTable.display();
-    std::cout << "GET RAND VAR" << std::endl;
-    std::string key = "\n";
-    std::cout << "Key: \'" << key << "\' | Value: \'" <<stringTable.getRandVal(std::string(key)) << "\'" << std::endl;  */
-    //===================DONE STORING INPUT=====================//
-    // Work on the output
-    
-    std::string outString = firstString;
-    std::string windowString = firstString;
-    std::string key = windowString;
-
+    std::unique_ptr<MappedCorpus> corpus_ptr;
     try {
-        std::string toAdd = stringTable.getRandVal(key);
-
-        while (outString.length() <= desired_length) {
-            // Append to outString
-            outString += toAdd;
-
-            // Update the window by removing the first character and adding the next one
-            // Remove the first character of windowString
-            windowString.erase(0, 1);
-            // Append the new string (toAdd) to the end of windowString
-            windowString.append(toAdd);
-
-            // Update the key for the next iteration
-            key = windowString;
+        corpus_ptr = std::make_unique<MappedCorpus>("merchant.txt", infile_length); // Map the corpus read-only, reusing the probed length
+    } catch (const std::runtime_error & e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    const MappedCorpus & corpus = *corpus_ptr;
 
-            // Get the next random value for the current window
-            toAdd = stringTable.getRandVal(key);
+    RunOptions options;
+    options.sampler = (sampler_kind == "scan") ? SCAN_SAMPLER : (sampler_kind == "prefix" ? PREFIX_SAMPLER : ALIAS_SAMPLER);
+    options.timed = hasFlag(argc, argv, "time");
+    options.compiled = hasFlag(argc, argv, "compile");
+    options.frozen = hasFlag(argc, argv, "freeze");
+    if (model_kind == "automaton") {
+        // int indices while the at most 3n edges fit in them (corpora up to about 700 MB), 64-bit beyond
+        if (corpus.size() <= static_cast<std::size_t>(std::numeric_limits<int>::max()) / 3) {
+            return runAutomaton<int>(corpus, window_size, desired_length, options);
         }
-    } catch (const std::runtime_error &e) {
-        std::cout << "Caught runtime_error: " << e.what() << std::endl;
+        return runAutomaton<std::int64_t>(corpus, window_size, desired_length, options);
     }
-
-    //outString.pop_back(); outString.pop_back();  // Remove any garbage characters
-
-    //std::cout << "====Final String====" << std::endl;
-    //std::cout << "'" << outString << "'\n";
-
-    // Create and open the output file
-    std::ofstream outfile("out.txt");  
-    if (!outfile) {
-        std::cerr << "Error creating output file!" << std::endl;
-        return 1;
+    // A dense array beats any table when it is small enough; it has nothing to compile or freeze
+    if (model_kind == "dense" || (model_kind == "auto" && !table_options)) {
+        std::string alphabet = DenseModel::alphabetOf(corpus); // Also what the DenseModel is built with
+        std::size_t dense_bytes = DenseModel::requiredBytes(alphabet.size(), window_size);
+        bool dense_fits = dense_bytes <= (static_cast<std::size_t>(dense_budget) << 20);
+        if (model_kind == "dense" && !dense_fits) {
+            std::cerr << "A dense model needs " << (dense_bytes >> 20) << " MiB for this window size, over --dense-budget=" << dense_budget << std::endl;
+            return 1;
+        }
+        if (dense_fits) {
+            return runDense(corpus, std::move(alphabet), window_size, desired_length, options);
+        }
     }
-    // Write outString to the file
-    outfile << outString;
-    outfile.close();
-    std::cout << "====Result exported to 'out.txt' file successfully!====" << std::endl;
-
-    return 0;
+    //Declare the Hash table structure and initialize the length = file length
+    // Common window sizes have their own instantiation with std::array keys
+    if (key_kind == "fixed") {
+        switch (window_size) {
+            case 3: return runTable<FixedWindow<3>>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
+            case 5: return runTable<FixedWindow<5>>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
+            case 8: return runTable<FixedWindow<8>>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
+            case 12: return runTable<FixedWindow<12>>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
+            default: break; // Other sizes use CorpusKeys
+        }
+    }
+    // Short windows are packed into integer keys; longer ones (and compiled runs) use CorpusKeys pointing into the corpus
+    bool packed = (key_kind == "packed") && !options.compiled;
+    if (packed && window_size <= 8) {
+        return runTable<PackedWindow<std::uint64_t>>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
+    }
+#ifdef __SIZEOF_INT128__
+    if (packed && window_size <= 16) {
+        return runTable<PackedWindow<unsigned __int128>>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
+    }
+#endif
+    return runTable<CorpusWindow>(table_kind, sizing_kind, corpus, window_size, desired_length, options);
 }
\ No newline at end of file